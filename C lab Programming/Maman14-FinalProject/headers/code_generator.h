@@ -72,10 +72,10 @@ typedef struct CodeGenerator {
  * using the provided lexer information.
  *
  * @param generator Pointer to the CodeGenerator structure to be initialized.
- * @param lexer Pointer to the Lexer containing input and file path information.
+ * @param lexer Pointer to the Lexer containing input and file path information, it must outlive the generator.
  * @return int Returns 0 on success, -1 on failure (e.g., if generator or lexer is NULL).
  */
-void code_generator_initialize(CodeGenerator * generator, Lexer lexer);
+void code_generator_initialize(CodeGenerator * generator, Lexer *lexer);
 
 /**
  * Free the resources used by the CodeGenerator.
@@ -44,23 +44,111 @@ typedef struct ErrorNode {
     struct ErrorNode *next;
 } ErrorNode;
 
+/**
+ * A run of a source that was read from another file, a macro library appended past the file's own text.
+ */
+typedef struct SourceRegion {
+    unsigned int base;       /* Offset of the region's first char in the source */
+    unsigned int first_line; /* Number of lines of the source before the region's first line */
+    char *file_path;         /* The file the region was read from (owned by the index) */
+} SourceRegion;
+
+/**
+ * The start offset of every line of a source, recorded by the lexer as it meets each newline,
+ * the macro calls the preprocessor spliced a body in for, so a diagnostic in a body can name its call,
+ * and the regions read from other files, so a diagnostic in one names that file and its own line.
+ * The lexer owns the arrays, every ErrorHandler of the same source shares them.
+ */
+typedef struct LineIndex {
+    unsigned int *starts;  /* starts[i] is the offset of the first char of line i + 1, in increasing order */
+    unsigned int count;    /* Number of lines recorded */
+    unsigned int capacity; /* Number of offsets the array can hold before it grows */
+    Token *calls;          /* calls[i] is the macro identifier at the call numbered i + 1 */
+    unsigned int call_count;    /* Number of calls recorded */
+    unsigned int call_capacity; /* Number of calls the array can hold before it grows */
+    SourceRegion *regions; /* The regions read from other files, in increasing order of base */
+    unsigned int region_count; /* Number of regions */
+} LineIndex;
+
 /**
  * Manages error handling and reporting.
  */
 typedef struct ErrorHandler {
-    String string;        /* The source code being processed */
+    String string;        /* The source code being processed (empty for a streamed source, errors then show no source line) */
+    const LineIndex *line_index; /* Line starts of the source, owned by the lexer (which must outlive the handler) */
     char *file_path;      /* The path to the source file */
     ErrorNode *error_list; /* Linked list of errors */
+    ErrorNode *error_tail; /* Last error of the list, so adding one doesn't walk it */
 } ErrorHandler;
 
+/**
+ * Initializes an empty line index.
+ *
+ * @param index Pointer to the LineIndex to initialize
+ */
+void line_index_initialize(LineIndex * index);
+
+/**
+ * Records the start of a line. Offsets that are not past the last recorded one are ignored.
+ *
+ * @param index Pointer to the LineIndex
+ * @param offset The offset of the first char of the line
+ */
+void line_index_add(LineIndex * index, unsigned int offset);
+
+/**
+ * Finds the line an offset is on, with a binary search over the line starts.
+ *
+ * @param index The LineIndex to search
+ * @param offset An offset in the source
+ * @return The line number (starting from 1)
+ */
+unsigned int line_index_find_line(LineIndex index, unsigned int offset);
+
+/**
+ * Finds the column of an offset (its distance from the start of its line).
+ *
+ * @param index The LineIndex to search
+ * @param offset An offset in the source
+ * @return The column (starting from 0)
+ */
+unsigned int line_index_find_column(LineIndex index, unsigned int offset);
+
+/**
+ * Records a macro call whose body is spliced into the token stream, the spliced tokens carry the call's number.
+ *
+ * @param index Pointer to the LineIndex
+ * @param call The macro's identifier token at the call
+ * @return The call's number (starting from 1), 0 once more than TOKEN_MAX_EXPANSION calls were recorded
+ */
+unsigned int line_index_add_call(LineIndex * index, Token call);
+
+/**
+ * Records that the source from an offset on was read from another file. It must be recorded before the
+ * region's line starts, which are then numbered from the region's first line.
+ *
+ * @param index Pointer to the LineIndex
+ * @param base The offset of the region's first char, past every region recorded before
+ * @param file_path The path of the file the region was read from (copied)
+ */
+void line_index_add_region(LineIndex * index, unsigned int base, const char * file_path);
+
+/**
+ * Frees the line starts, the macro calls and the regions of the index.
+ *
+ * @param index Pointer to the LineIndex to free
+ */
+void line_index_free(LineIndex * index);
+
 /**
  * Initializes the error handler.
  *
  * @param handler Pointer to the ErrorHandler to initialize
  * @param source_string The source code being processed
+ * @param line_index Pointer to the line starts of the source, kept rather than copied so it sees every line recorded later (an empty index shows no source lines)
  * @param filePath The path to the source file
  */
-void error_handler_initialize(ErrorHandler * handler, String source_string, char * filePath);
+void error_handler_initialize(ErrorHandler * handler, String source_string, const LineIndex * line_index, char * filePath);
 
 /**
  * Adds a token error to the error list.
@@ -80,6 +168,15 @@ void error_handler_add_token_error(ErrorHandler * handler, ErrorSource source, T
  */
 void error_handler_add_char_error(ErrorHandler * handler, ErrorSource source, CharError error);
 
+/**
+ * Moves every error of another handler to the end of the error list, leaving the other handler's list empty.
+ * Char errors are given the line and column of their offset in this handler's line index.
+ *
+ * @param handler Pointer to the ErrorHandler that takes the errors
+ * @param other Pointer to the ErrorHandler the errors are taken from
+ */
+void error_handler_take_errors(ErrorHandler * handler, ErrorHandler * other);
+
 /**
  * Outputs all errors in the error list to the user.
  *
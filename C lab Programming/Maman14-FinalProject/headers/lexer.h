@@ -19,9 +19,44 @@ typedef struct Lexer {
     char *file_path; /* Relative path to the source file */
 
     ErrorHandler error_handler; /* Error handler for reporting lexer errors */
-    TokenNode *token_list; /* List of tokens produced by the lexer */
+    TokenArray tokens; /* Tokens produced by the lexer, in source order */
+    LineIndex line_index; /* Start offset of every line lexed so far, shared by the error handlers of later stages */
+    unsigned int macro_count; /* Number of macr tokens lexed */
+    unsigned int include_count; /* Number of .include tokens lexed, when both counts are zero there is nothing to preprocess */
 } Lexer;
 
+/**
+ * A lexer that reads its source through a fixed-size ring buffer and hands out one token at a time,
+ * so memory stays bounded by the ring no matter how large the input is.
+ * Tokens are the same as the ones lexer_analyze produces (index is the offset in the file), the line and column
+ * of the last one are kept in token_line and token_column.
+ * A token's index is an unsigned int, so only the first UINT_MAX bytes are lexed: a token that would end past them
+ * is reported as an error and an EOF token is handed out instead.
+ * Only the stream is bounded, the assembler itself still reads the whole file through lexer_initialize_from_file,
+ * since the preprocessor and the error reports need the full source.
+ */
+typedef struct LexerStream {
+    FILE *file; /* The source file, read a ring's worth at a time */
+    char *file_path; /* Relative path to the source file */
+
+    char *ring; /* The buffered bytes, a file offset lives in slot (offset & (capacity - 1)) */
+    char *text; /* Scratch space for the text of a token that wraps around the end of the ring */
+    unsigned long capacity; /* Size of the ring (a power of two) */
+    unsigned long head; /* File offset of the oldest byte that must stay in the ring */
+    unsigned long tail; /* File offset one past the newest byte read */
+    unsigned long cursor; /* File offset of the next char to scan */
+    unsigned long line_start; /* File offset of the first char of the current line */
+    unsigned long token_start; /* File offset of the last token handed out */
+    unsigned int token_line; /* Line of the last token handed out (a stream keeps no line index to look it up in) */
+    unsigned int token_column; /* Column of the last token handed out */
+    unsigned int line_number; /* Current line number (starting from 1) */
+    bool end_of_file; /* The file has no more bytes, the EOF sentinel follows tail */
+    bool finished; /* The EOF token was handed out */
+
+    LineIndex no_lines; /* An empty index for the error handler, a stream keeps no line starts */
+    ErrorHandler error_handler; /* Error handler for reporting lexer errors (the source is never held, so no source lines are shown) */
+} LexerStream;
+
 /**
  * Initializes the lexer with a C-style string.
  * @param lexer Pointer to the Lexer to initialize.
@@ -33,7 +68,7 @@ void lexer_initialize_from_cstr(Lexer *lexer, char *source_string);
  * Initializes the lexer with a file.
  * @param lexer Pointer to the Lexer to initialize.
  * @param file_path Path to the source file.
- * @return true if initialization was successful, false otherwise.
+ * @return true if initialization was successful, false otherwise (the file couldn't be opened, or it is UINT_MAX bytes or longer).
  */
 bool lexer_initialize_from_file(Lexer *lexer, char *file_path);
 
@@ -113,10 +148,81 @@ void lexer_tokenize_eof(Lexer *lexer);
 
 /**
  * Performs a full lexical analysis on the source code.
+ * Built with -DLEXER_THREADS, a large source is lexed in chunks on one thread per core (see lexer_analyze_chunks).
  * @param lexer Pointer to the Lexer to perform analysis with.
  */
 void lexer_analyze(Lexer *lexer);
 
+/**
+ * Performs a full lexical analysis by cutting the source in chunks at line starts and lexing every chunk on its own,
+ * on a thread each when built with -DLEXER_THREADS (one after another otherwise).
+ * The chunks' tokens, line starts and errors are joined in source order, a string running over a cut is handed
+ * to the chunk it started in, so the result is the same as lexer_analyze's.
+ * @param lexer Pointer to the Lexer, nothing may be lexed yet.
+ * @param chunk_count The number of chunks to cut the source in (at most 16).
+ */
+void lexer_analyze_chunks(Lexer *lexer, unsigned int chunk_count);
+
 int lexer_is_end_of_input(Lexer *lexer);
 
+/**
+ * Gets the text of a token inside the source it was lexed from.
+ * The text is not null-terminated, token.length tells how many chars belong to the token.
+ * @param token The token to look up.
+ * @param source The source the token was produced from.
+ * @return Pointer to the first char of the token.
+ */
+const char *token_text(Token token, String source);
+
+/**
+ * Copies the text of a token into a new String, for the few places that must own it.
+ * @param token The token to copy.
+ * @param source The source the token was produced from.
+ * @return A new String (the caller frees it).
+ */
+String token_to_string(Token token, String source);
+
+/**
+ * Checks whether two tokens of the same source have the same text.
+ * @param first The first token.
+ * @param second The second token.
+ * @param source The source both tokens were produced from.
+ * @return true if the texts match, false otherwise.
+ */
+bool token_equals(Token first, Token second, String source);
+
+/**
+ * Opens a source file for streaming.
+ * lexer_stream_close must be called even when opening fails.
+ * @param stream Pointer to the LexerStream to initialize.
+ * @param file_path Path to the source file (without the .as extension).
+ * @param capacity Size of the ring buffer in bytes (rounded up to a power of two). A token longer than the ring is reported as an error.
+ * @return true if the file was opened, false otherwise.
+ */
+bool lexer_stream_open(LexerStream *stream, char *file_path, unsigned long capacity);
+
+/**
+ * Scans the next token of the stream.
+ * The last token handed out is always an EOF token, after it the stream is exhausted.
+ * @param stream Pointer to the LexerStream.
+ * @param token Output, the scanned token.
+ * @return true if a token was produced, false once the stream is exhausted.
+ */
+bool lexer_stream_next(LexerStream *stream, Token *token);
+
+/**
+ * Gets the text of the token last returned by lexer_stream_next.
+ * The text is not null-terminated and stays valid until the next call to lexer_stream_next.
+ * @param stream Pointer to the LexerStream.
+ * @param token The token last returned by the stream.
+ * @return Pointer to the first char of the token.
+ */
+const char *lexer_stream_token_text(LexerStream *stream, Token token);
+
+/**
+ * Closes the stream and frees its buffers and errors.
+ * @param stream Pointer to the LexerStream to close.
+ */
+void lexer_stream_close(LexerStream *stream);
+
 #endif /* LEXER_H */
\ No newline at end of file
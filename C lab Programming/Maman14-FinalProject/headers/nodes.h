@@ -3,6 +3,7 @@
 
 #include "error_handler.h"
 #include "token.h"
+#include "safe_allocations.h"
 
 typedef enum NodeType {
     ENTRY_NODE,
@@ -32,8 +33,16 @@ typedef struct ExternalNodeList {
     struct ExternalNodeList *next; /* Pointer to the next external node */
 } ExternalNodeList;
 
+/* Maximum positive value for a 15-bit signed integer */
+#define MAX_15BIT_SIGNED_INT  (signed int)(((2 << (14-1))) -1)
+/* Minimum negative value for a 15-bit signed integer */
+#define MIN_15BIT_SIGNED_INT (signed int)(-(2 << (14-1)))
+
 typedef struct DataNode {
-    TokenReferenceNode *data_numbers; /* List of numbers in the data node */
+    short *numbers; /* The directive's values, packed in source order */
+    unsigned int count; /* Number of values in numbers */
+    Token *first_number; /* The first number token, where the values can be traced back to the source */
+    bool is_out_of_range; /* True if a value doesn't fit 15 bits, such a value is stored as 0 */
     bool has_parser_error; /* True if a parser error occurred, false otherwise */
 } DataNode;
 
@@ -61,6 +70,37 @@ typedef struct InstructionNodeList {
     struct InstructionNodeList *next; /* Next node */
 } InstructionNodeList;
 
+/* Enum representing different addressing modes in assembly */
+typedef enum AddressingMode {
+    ADDRESSING_MODE_IMMEDIATE = 1,          /* 0001 -  Immediate value (e.g., #5) */
+    ADDRESSING_MODE_DIRECT = 2,            /* 0010 -  Direct label reference */
+    ADDRESSING_MODE_INDIRECT_REGISTER = 4,  /* 0100 - Dereferencing a register (e.g., *r3) */
+    ADDRESSING_MODE_DIRECT_REGISTER = 8     /* 1000 - Direct register access */
+} AddressingMode;
+
+/* Flags of an instruction table row */
+#define INSTRUCTION_SOURCE_DEREFERENCED 1
+#define INSTRUCTION_DESTINATION_DEREFERENCED 2
+
+/*
+ * The unit's instructions in source order, one row per instruction, each field in its own array.
+ * Operands sit where they are encoded: a one-operand instruction only has a destination.
+ * An absent operand has mode 0.
+ */
+typedef struct InstructionTable {
+    unsigned char *opcode; /* The operation, as its distance from TOKEN_MOV */
+    unsigned char *source_mode; /* The AddressingMode of the source operand */
+    unsigned char *destination_mode; /* The AddressingMode of the destination operand */
+    unsigned char *flags; /* INSTRUCTION_*_DEREFERENCED bits */
+    int *source_value; /* An immediate's value or a register's number, 0 for a label */
+    int *destination_value; /* Same for the destination operand */
+    unsigned int *token; /* Index of the operation token */
+    unsigned int *source_token; /* Index of the source operand token */
+    unsigned int *destination_token; /* Index of the destination operand token */
+    unsigned int count; /* Number of rows */
+    unsigned int capacity; /* Number of rows the arrays hold */
+} InstructionTable;
+
 typedef struct GuidanceNodeList {
     union {
         DataNode dataNode;
@@ -72,7 +112,8 @@ typedef struct GuidanceNodeList {
 
 typedef struct LabelNode {
     Token *label; /* The label identifier (NULL for guidance nodes without a label) */
-    InstructionNodeList *instruction_list; /* List of instruction sentences (NULL for guidance labels) */
+    unsigned int first_instruction; /* The label's first row in the unit's instruction table */
+    unsigned int instruction_count; /* Number of the label's rows in the instruction table (0 for guidance labels) */
     GuidanceNodeList *guidance_list; /* List of guidance sentences (NULL for instruction labels) */
     unsigned int size; /* The memory size occupied by the label */
     unsigned int position; /* The memory position of the label */
@@ -108,7 +149,10 @@ typedef struct TranslationUnit {
     LabelNodeList *instruction_label_list; /* The instructions label list */
     LabelNodeList *guidance_label_list; /* The guidance label list */
     ErrorHandler error_handler; /* The error handler of the translation unit */
-    TokenNode *tokens; /* The token list reference from the lexer */
+    TokenArray tokens; /* The token array reference from the lexer */
+    unsigned int current; /* Index of the token the parser is currently looking at */
+    InstructionTable instructions; /* The instructions of all the labels, in the arena too */
+    Arena arena; /* Every node of the unit's lists is allocated here and released at once */
 } TranslationUnit;
 
 #endif /* NODE_H */
\ No newline at end of file
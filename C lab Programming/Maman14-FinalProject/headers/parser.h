@@ -10,14 +10,14 @@
  * including initializing all pointers to NULL and setting up the error handler.
  *
  * @param unit Pointer to the TranslationUnit to be initialized.
- * @param lexer The Lexer containing the tokens to be parsed.
+ * @param lexer Pointer to the Lexer containing the tokens to be parsed, it must outlive the unit.
  */
-void parser_initialize_translation_unit(TranslationUnit * unit, Lexer lexer);
+void parser_initialize_translation_unit(TranslationUnit * unit, Lexer *lexer);
 
 /**
  * Frees all memory associated with the translation unit.
- * This includes freeing all nodes (external, entry, instruction labels, guidance labels)
- * and cleaning up the error handler.
+ * All nodes (external, entry, instruction labels, guidance labels and their lists) live in the unit's arena
+ * and are released together, then the error handler is cleaned up.
  *
  * @param unit Pointer to the TranslationUnit to be freed.
  */
@@ -44,7 +44,7 @@ DataNode parse_data_directive_guidance(TranslationUnit * unit);
 
 /**
  * Frees the memory associated with a DataNode.
- * This includes freeing the list of number tokens.
+ * The packed values live in the unit's arena, so nothing is freed before parser_free_translation_unit.
  *
  * @param data_node The DataNode to be freed.
  */
@@ -70,7 +70,7 @@ GuidanceNodeList * parser_parse_guidance_list(TranslationUnit * unit);
 
 /**
  * Frees the memory associated with a list of guidance nodes.
- * This includes freeing both DataNodes and StringNodes.
+ * The nodes live in the unit's arena, so nothing is freed before parser_free_translation_unit.
  *
  * @param guidance_list Pointer to the head of the GuidanceNodeList to be freed.
  */
@@ -87,14 +87,28 @@ InstructionNode parser_parse_instruction(TranslationUnit * unit);
 
 /**
  * Parses multiple consecutive assembly instructions.
+ * Each one is also appended as a row of the unit's instruction table. parse_translation_unit_content
+ * only keeps the rows, labels refer to theirs by first_instruction and instruction_count.
  *
  * @param unit Pointer to the TranslationUnit being parsed.
  * @return A linked list of InstructionNodes.
  */
 InstructionNodeList * parser_parse_instruction_list(TranslationUnit * unit);
 
+/**
+ * Appends an instruction as a row of an instruction table.
+ * The operands' addressing modes are determined here, once, along with their values,
+ * so the later stages read them from the row. Nothing is appended if the table is full.
+ *
+ * @param table Pointer to the InstructionTable to append to.
+ * @param tokens The token array the instruction's tokens belong to, the row stores indices into it.
+ * @param node The parsed InstructionNode.
+ */
+void parser_append_instruction_row(InstructionTable * table, Token * tokens, InstructionNode node);
+
 /**
  * Frees the memory associated with a list of instruction nodes.
+ * The nodes live in the unit's arena, so nothing is freed before parser_free_translation_unit.
  *
  * @param instruction_list Pointer to the head of the InstructionNodeList to be freed.
  */
@@ -130,11 +144,24 @@ LabelNode parse_labeled_statement(TranslationUnit * unit);
  * This is the main parsing function that handles all elements of the assembly code,
  * including directives (.entry, .extern), labels, instructions, and guidance directives.
  * It populates the TranslationUnit structure with all parsed information.
+ * Built with -DPARSER_THREADS, a large unit is parsed in ranges on one thread per core (see parser_parse_ranges).
  *
  * @param unit Pointer to the TranslationUnit to be parsed and populated.
  */
 void parse_translation_unit_content(TranslationUnit * unit);
 
+/**
+ * Parses the entire content of the translation unit by cutting its tokens in ranges of whole statements
+ * and parsing every range on its own, on a thread each when built with -DPARSER_THREADS (one after another otherwise).
+ * A range starts on a line that starts a new statement (a label, .extern or .entry) and never right after
+ * a label whose statement is still to come. The ranges' lists, instruction rows and errors are joined
+ * in source order, so the result is the same as parse_translation_unit_content's.
+ *
+ * @param unit Pointer to the TranslationUnit to be parsed and populated, nothing may be parsed yet.
+ * @param range_count The number of ranges to cut the tokens in (at most 16).
+ */
+void parser_parse_ranges(TranslationUnit * unit, unsigned int range_count);
+
 /**
  * Frees the memory associated with a list of assembly statements.
  *
@@ -9,42 +9,130 @@
 /**
  * Represents a macro in the source code.
  * A macro consists of an identifier and its content, along with the start and end indices in the source file.
+ * The content is lexed once with the rest of the file, every call splices the same run of body tokens in and
+ * the tokens keep their positions in the definition, so a diagnostic shows the line the text was written on.
+ * Each call is recorded in the lexer's line index and its spliced tokens carry its number, so the diagnostic
+ * also names the call the body was expanded at.
+ * The content's text is never copied, it is a range of the source.
  */
 typedef struct Macro {
     Token identifier;  /* The identifier token of the macro */
-    String content;    /* The content of the macro expansion */
     int start_index;   /* The starting index of the macro in the source file */
     int end_index;     /* The ending index of the macro in the source file */
+    unsigned int body_start; /* Index of the first body token in the lexer's token array */
+    unsigned int body_end;   /* Index one past the last body token (the body keeps its final EOL) */
+    unsigned int content_start;  /* Index of the first char of the content in the source file */
+    unsigned int content_length; /* Number of chars of the content */
 } Macro;
 
+/**
+ * How far a macro's expansion has been worked out.
+ */
+typedef enum ExpansionState {
+    EXPANSION_PENDING,     /* The macro was not called yet */
+    EXPANSION_IN_PROGRESS, /* The macro's body is being expanded, a call of it now is a cycle */
+    EXPANSION_DONE         /* The expansion is in the preprocessor's expansion pool */
+} ExpansionState;
+
+/**
+ * A macro's body with every call of another macro in it replaced by that macro's expansion.
+ * It is worked out at the macro's first call, inner macros first, and every later call copies it,
+ * so a deep hierarchy of macros is expanded once per macro and not once per use.
+ */
+typedef struct MacroExpansion {
+    unsigned int token_start; /* Index of the expansion's first token in the preprocessor's expansion_tokens */
+    unsigned int token_count; /* Number of tokens in the expansion */
+    unsigned int piece_start; /* Index of the expansion's first piece in the preprocessor's expansion_pieces */
+    unsigned int piece_count; /* Number of pieces in the expansion */
+    ExpansionState state;     /* How far the expansion has been worked out */
+} MacroExpansion;
+
 /**
  * Represents a node in the linked list of macros.
  * Each node contains a macro and a pointer to the next node in the list.
  */
 typedef struct MacroList {
-    Macro macro;               /* The current macro */
+    Macro macro;               /* The current macro (first, so a pointer to it is a pointer to its node) */
+    MacroExpansion expansion;  /* The macro's expansion, once it is called */
     struct MacroList *next;    /* Pointer to the next macro in the list */
 } MacroList;
 
+/**
+ * A run of the original source that is part of the expanded source, either text kept as written or a macro's content.
+ */
+typedef struct SourcePiece {
+    unsigned int start;  /* Index of the first char of the run in the source file */
+    unsigned int length; /* Number of chars in the run */
+} SourcePiece;
+
+/**
+ * The expanded source as a list of pieces of the original source, in order.
+ * A macro called many times adds one small piece per call instead of a copy of its content,
+ * the text is only put together (flattened) when it is written or asked for.
+ */
+typedef struct PieceTable {
+    SourcePiece *pieces;   /* The pieces, in the order their text appears in the expanded source */
+    unsigned int count;    /* Number of pieces */
+    unsigned int capacity; /* Number of pieces the array can hold before it grows */
+} PieceTable;
+
+/**
+ * A macro library, a file holding only macro definitions that a source file pulls in with .include "path".
+ * The library is lexed and its macros collected once, then a precompiled image of its tokens, macros and a hash index
+ * of them is kept next to it (path.amc). Later runs map the image in and check it against the library's content hash,
+ * so the library is only lexed again when it changes (or the image is corrupt).
+ * The library's text is appended to the including file's source, past its EOF sentinel, so its tokens stay views
+ * into one source once they are moved by base. The appended text is recorded as a region of the library's file
+ * in the line index, so diagnostics in it name the library and its own lines.
+ */
+typedef struct MacroLibrary {
+    char *path;                 /* Path of the library (without the .as extension), from the including file's directory */
+    void *image;                /* The precompiled image, mapped from the cache file or built in memory */
+    unsigned long image_size;   /* Size of the image in bytes */
+    bool mapped;                /* The image is mapped from the cache file (otherwise it is allocated) */
+    const Token *tokens;        /* The library's tokens, their offsets are in the library's own text */
+    const Macro *macros;        /* The library's macros, in the order they are defined */
+    const unsigned int *table;  /* Hash index of the macros by identifier (macro index + 1, 0 cells are empty) */
+    unsigned int macro_count;   /* Number of macros */
+    unsigned int table_size;    /* Number of cells in the hash index */
+    unsigned int base;          /* Offset of the library's text in the source, its tokens are moved by this much */
+    MacroExpansion *expansions; /* The expansion of every macro, by its index in macros (the image is read only) */
+} MacroLibrary;
+
 /**
  * Represents the preprocessor, which handles macro processing and expansion.
  * The preprocessor maintains a list of macros, processes the source code, and handles errors.
  */
 typedef struct Preprocessor {
-    String processed_source;   /* The source file content after preprocessing */
-    MacroList *macro_list;     /* List of macros found in the source */
+    String processed_source;   /* The source file content after preprocessing (only flattened by preprocessor_expand_macros) */
+    PieceTable expanded_source; /* The source file content after preprocessing, as pieces of the original source */
+    MacroList *macro_list;     /* List of macros found in the source, in the order they are defined */
+    MacroList *macro_list_tail; /* Last node of the macro list, new macros are appended after it */
+    MacroList **macro_table;   /* Hash table of the macro list's nodes by identifier (linear probing, NULL cells are empty) */
+    unsigned int macro_table_size; /* Number of cells in the hash table */
+    unsigned int macro_count;  /* Number of macros in the list (and in the table) */
     ErrorHandler error_handler; /* Error handler for preprocessing errors */
-    TokenNode *tokens;         /* Token list reference from the lexer */
+    Lexer *lexer;              /* The lexer whose token stream is expanded */
+    String source_code;        /* The lexer's source, which the tokens are views into */
+    TokenArray tokens;         /* Token array reference from the lexer */
+    unsigned int current;      /* Index of the token currently being examined */
+    bool write_expanded_file;  /* Render the expanded source into the .am file (on by default) */
+    char *expanded_file_path;  /* Path of the .am file (the error handler names the lexer's file instead) */
+    MacroLibrary *libraries;   /* Macro libraries included by the source, in the order they are included */
+    unsigned int library_count; /* Number of included libraries */
+    unsigned int file_length;  /* Length of the file's own text (with the EOF sentinel), library text follows it */
+    TokenArray expansion_tokens; /* The tokens of every macro expansion worked out so far, one run per macro */
+    PieceTable expansion_pieces; /* The text of every macro expansion worked out so far, one run of pieces per macro */
 } Preprocessor;
 
 /**
  * Initializes the preprocessor with data from the lexer.
  *
  * @param preprocessor Pointer to the Preprocessor to initialize.
- * @param lexer The Lexer containing tokenized source.
+ * @param lexer The Lexer containing tokenized source, its token stream is replaced by the expanded one.
  * @param file_path The path of the source file (without extension).
  */
-void preprocessor_initialize(Preprocessor * preprocessor, Lexer lexer, char * file_path);
+void preprocessor_initialize(Preprocessor * preprocessor, Lexer * lexer, char * file_path);
 
 /**
  * Frees all memory allocated for the preprocessor.
@@ -71,9 +159,21 @@ void preprocessor_create_macro(Preprocessor * preprocessor, String source);
  */
 void preprocessor_create_macro_list(Preprocessor * preprocessor, String source);
 
+/**
+ * Looks up a macro by its identifier in the preprocessor's hash table, then in the included libraries' hash indexes
+ * in the order they were included.
+ *
+ * @param preprocessor Pointer to the Preprocessor.
+ * @param identifier A token holding the identifier to look up.
+ * @param source The original source code as a String.
+ * @return Pointer to the macro with that identifier, NULL if there is none.
+ */
+Macro *preprocessor_find_macro(Preprocessor * preprocessor, Token identifier, String source);
+
 /**
  * Adds a macro to the end of the preprocessor's macro list.
- * This function appends a new macro to the linked list of macros maintained by the preprocessor.
+ * This function appends a new macro to the linked list of macros maintained by the preprocessor
+ * and indexes it by its identifier in the hash table.
  *
  * @param preprocessor Pointer to the Preprocessor.
  * @param macro The Macro to be added.
@@ -91,15 +191,42 @@ void preprocessor_display_macro_list(Preprocessor * preprocessor);
 /**
  * Generates the preprocessed source code by expanding macros.
  * This function replaces macro identifiers in the source code with their corresponding content.
+ * The expansion is built as a piece table (expanded_source) and then flattened into processed_source.
  *
  * @param preprocessor Pointer to the Preprocessor.
  * @param source The original source code as a String.
  */
 void preprocessor_expand_macros(Preprocessor * preprocessor, String source);
 
+/**
+ * Expands macros at the token level.
+ * Macro definitions are dropped from the token stream and every macro call is replaced by the already lexed
+ * body tokens, so the expanded stream never has to be lexed again. A body may call other macros (but not,
+ * directly or through others, its own macro), the calls are expanded in it. Every token keeps its position in the
+ * original source, so diagnostics point to the line the token was written on, and a spliced token carries the number
+ * of the top level call that spliced it in (see line_index_add_call), so diagnostics name that call too.
+ * The lexer's token array is replaced by the expanded one.
+ *
+ * @param preprocessor Pointer to the Preprocessor.
+ * @param source The original source code as a String.
+ */
+void preprocessor_expand_tokens(Preprocessor * preprocessor, String source);
+
+/**
+ * Loads a macro library for an .include token. A relative path is taken from the including file's directory.
+ * The precompiled image next to the library is mapped in when its content hash matches the library, otherwise the
+ * library is lexed, its macros collected and a new image is written. The library's text is appended to the source.
+ * Errors inside the library are reported with the library's path, the include itself gets a preprocessor error.
+ *
+ * @param preprocessor Pointer to the Preprocessor.
+ * @param include The index of the .include token in the token array.
+ */
+void preprocessor_include_library(Preprocessor * preprocessor, unsigned int include);
+
 /**
  * Performs preprocessing on the source string.
- * This function creates the macro list, expands macros, and writes the processed source to a file.
+ * This function loads the included macro libraries, creates the macro list, expands macros in the lexer's token
+ * stream and, unless write_expanded_file was cleared, writes the expanded source to the .am file straight from its pieces.
  *
  * @param preprocessor The preprocessor.
  * @param source The source file as a string.
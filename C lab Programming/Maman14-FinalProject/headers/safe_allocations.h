@@ -24,4 +24,54 @@ void *safe_realloc(void *__ptr, size_t __size);
 */
 void *safe_calloc(size_t __nmemb, size_t __size);
 
+/**
+ * A block of memory an arena hands out from, the blocks of an arena are chained newest first.
+ */
+typedef struct ArenaSlab {
+    struct ArenaSlab *next; /* The slab filled before this one */
+    size_t used;            /* Number of bytes handed out from this slab */
+    size_t capacity;        /* Number of bytes this slab can hand out */
+} ArenaSlab;
+
+/**
+ * A bump allocator, many small objects that live and die together are carved out of a few large slabs
+ * and released all at once. Every slab is twice the size of the one before, so the slabs stay few.
+ */
+typedef struct Arena {
+    ArenaSlab *slabs;  /* The slab currently handed out from (NULL before the first allocation) */
+    size_t slab_size;  /* Size of the next slab to allocate */
+} Arena;
+
+/**
+ * Initializes an empty arena, no memory is taken until the first allocation.
+ *
+ * @param arena Pointer to the Arena to initialize.
+ * @param slab_size Size of the first slab in bytes.
+*/
+void arena_initialize(Arena *arena, size_t slab_size);
+
+/**
+ * Hands out a block from the arena, aligned for any type. Like safe_malloc, exits when memory runs out.
+ *
+ * @param arena Pointer to the Arena.
+ * @param size Size of the block in bytes.
+ * @return Pointer to the (uninitialized) block, valid until arena_free.
+*/
+void *arena_allocate(Arena *arena, size_t size);
+
+/**
+ * Releases every block handed out from the arena at once, the arena can be used again afterwards.
+ *
+ * @param arena Pointer to the Arena.
+*/
+void arena_free(Arena *arena);
+
+/**
+ * Moves every slab of another arena into this one, the other arena's blocks stay valid until this arena is freed.
+ *
+ * @param arena Pointer to the Arena that takes the slabs.
+ * @param other Pointer to the Arena the slabs are taken from, it is left empty.
+*/
+void arena_absorb(Arena *arena, Arena *other);
+
 #endif /*SAFE_ALLOCATIONS_H*/
\ No newline at end of file
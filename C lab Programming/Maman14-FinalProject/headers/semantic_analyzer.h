@@ -4,14 +4,6 @@
 #include "parser.h"
 #include "lexer.h"
 
-/* Enum representing different addressing modes in assembly */
-typedef enum AddressingMode {
-    ADDRESSING_MODE_IMMEDIATE = 1,          /* 0001 -  Immediate value (e.g., #5) */
-    ADDRESSING_MODE_DIRECT = 2,            /* 0010 -  Direct label reference */
-    ADDRESSING_MODE_INDIRECT_REGISTER = 4,  /* 0100 - Dereferencing a register (e.g., *r3) */
-    ADDRESSING_MODE_DIRECT_REGISTER = 8     /* 1000 - Direct register access */
-} AddressingMode;
-
 /* Enum for types of identifiers in the hash table */
 typedef enum IdentifierCellType {
     IDENTIFIER_CELL_LABEL, /* Represents a label in the code */
@@ -20,7 +12,7 @@ typedef enum IdentifierCellType {
 
 /* Structure for storing identifier information in the hash table */
 typedef struct IdentifierCell {
-    String *key; /* The identifier name (label or external symbol) */
+    Token *key; /* The identifier token (label or external symbol), its name is read from the analyzer's source */
 
     union {
         LabelNode *label; /* Pointer to label node if it's a label */
@@ -35,22 +27,12 @@ typedef struct IdentifierCell {
 typedef struct SemanticAnalyzer {
     IdentifierCell *hash; /* Pointer to the hash table of identifiers */
     unsigned int size; /* Number of cells in the array (hashTable) */
+    InstructionTable *instructions; /* The unit's instruction table, the labels' rows are validated from it */
+    Token *tokens; /* The unit's tokens, which the table's token indices refer to */
 
     ErrorHandler error_handler; /* Error handler for reporting semantic errors */
 } SemanticAnalyzer;
 
-/**
- * Computes a hash value for a given string.
- *
- * This function implements the djb2 hash algorithm, which is known for its
- * simplicity and good distribution properties. The algorithm iterates through
- * each character of the string, updating the hash value at each step.
- *
- * @param str The String structure containing the string to be hashed.
- * @return An unsigned long representing the computed hash value.
- */
-unsigned long compute_string_hash(String str);
-
 /**
  * Initializes the analyzer with data from the translation unit and lexer.
  *
@@ -60,9 +42,9 @@ unsigned long compute_string_hash(String str);
  *
  * @param analyzer Pointer to the SemanticAnalyzer to initialize.
  * @param unit Pointer to the parsed TranslationUnit.
- * @param lexer The Lexer containing source information.
+ * @param lexer Pointer to the Lexer containing source information, it must outlive the analyzer.
  */
-void semantic_analyzer_initialize(SemanticAnalyzer *analyzer, TranslationUnit *unit, Lexer lexer);
+void semantic_analyzer_initialize(SemanticAnalyzer *analyzer, TranslationUnit *unit, Lexer *lexer);
 
 /**
  * Frees all memory associated with the anaylyzer.
@@ -83,10 +65,10 @@ void semantic_analyzer_free(SemanticAnalyzer *analyzer);
  * If it reaches the end of the table, it wraps around to the beginning.
  *
  * @param analyzer Pointer to the SemanticAnalyzer.
- * @param key The identifier name to look up.
+ * @param key A token holding the identifier name to look up.
  * @return Pointer to the IdentifierHashCell if found, NULL otherwise.
  */
-IdentifierCell *semantic_analyzer_find_identifier(SemanticAnalyzer *analyzer, String key);
+IdentifierCell *semantic_analyzer_find_identifier(SemanticAnalyzer *analyzer, Token key);
 
 /**
  * Inserts a new identifier hash cell into the validator's hash table.
@@ -66,6 +66,15 @@ void string_append_char(String * str, char ch);
  */
 void string_append_cstr(String *str, const char *cstr);
 
+/**
+ * Append a run of characters (not necessarily null-terminated) to the end of a String.
+ *
+ * @param str Pointer to the String to modify.
+ * @param chars The first character to append.
+ * @param count Number of characters to append.
+ */
+void string_append_chars(String *str, const char *chars, unsigned int count);
+
 /**
  * Append one String to another.
  *
@@ -137,4 +146,17 @@ void string_remove_range(String *str, int start, int end);
  */
 void string_replace(String *str, String pattern, String replacement);
 
+/**
+ * Computes a hash value for a run of characters.
+ *
+ * This function implements the djb2 hash algorithm, which is known for its
+ * simplicity and good distribution properties. The algorithm iterates through
+ * each character of the run, updating the hash value at each step.
+ *
+ * @param data The first character to hash (does not have to be null-terminated).
+ * @param length The number of characters to hash.
+ * @return An unsigned long representing the computed hash value.
+ */
+unsigned long compute_string_hash(const char *data, unsigned int length);
+
 #endif /* STRING_UTIL */
\ No newline at end of file
@@ -32,6 +32,7 @@ typedef enum {
     TOKEN_STRING_INS, /* .string */
     TOKEN_ENTRY_INS, /* .entry */
     TOKEN_EXTERN_INS, /* .extern */
+    TOKEN_INCLUDE_INS, /* .include (pulls in a macro library, handled by the preprocessor) */
 
     TOKEN_COMMA, /* , */
     TOKEN_COLON, /* : */
@@ -44,22 +45,26 @@ typedef enum {
     TOKEN_EOFT /* end of file token (end of token stream) \0 */
 } TokenType;
 
+/* The largest macro call number a token can carry, the calls after it leave their tokens unnumbered */
+#define TOKEN_MAX_EXPANSION 0xFFFFFFUL
+
+/*
+ * A token is 16 bytes. Its line and column are not stored, they are looked up from the offset in the lexer's
+ * line index only when a diagnostic needs them (see line_index_find_line and line_index_find_column).
+ */
 typedef struct Token {
-    TokenType type;  /* Token type */
+    unsigned int type : 8;  /* Token type (a TokenType) */
+    unsigned int expansion : 24; /* Number of the macro call that spliced the token in (see line_index_add_call), 0 if written in place */
     unsigned int index;  /* Index of the starting char of the token (in the file) */
-    unsigned int index_in_line; /* Index of the starting char of the token (in the token line) */
-    unsigned int line;  /* Index of a token is inside */
-    String string; /* String data */
+    unsigned int length : 31; /* Number of source chars the token spans, starting at index (the text itself stays in the source) */
+    unsigned int is_overflow : 1; /* 1 if a number's literal doesn't fit an int, its value is then saturated */
+    int value; /* Payload: a number's value (saturated to the int range), a register's number, 0 for other tokens */
 } Token;
 
-typedef struct TokenNode {
-    Token token;  /* the current token */
-    struct TokenNode *next;  /* the next token */
-} TokenNode;
-
-typedef struct TokenReferenceNode {
-    Token *token; /* Current token */
-    struct TokenReferenceNode *next; /* Next token */
-} TokenReferenceNode;
+typedef struct TokenArray {
+    Token *data;  /* contiguous buffer of tokens, in source order */
+    unsigned int count;  /* number of tokens stored in the buffer */
+    unsigned int capacity;  /* number of tokens the buffer can hold before it grows */
+} TokenArray;
 
 #endif /* TOKEN_H */
\ No newline at end of file
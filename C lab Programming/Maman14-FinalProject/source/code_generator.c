@@ -13,7 +13,6 @@
 #define STARTING_POSITION 100
 #define MAX_POSITION 9999
 
-#define TokenTypeToInstrCode(type) (InstructionCode)(type - TOKEN_MOV)
 /* 0x7FFF is a mask for 15 bit */
 #define IntTo2Complement(value) ((value >= 0)? (value & 0x7FFF) : (((~(-value) & 0x7FFF) + 1) & 0x7FFF))
 #define InstrMemToBinary(inst) ( \
@@ -27,18 +26,17 @@
 
 
 static void generate_instruction_memory(CodeGenerator *generator, SemanticAnalyzer *analyzer,
-                                        InstructionNode node, int *position);
+                                        InstructionTable *table, Token *tokens, unsigned int row, int *position);
 
 static void write_to_object_file(CodeGenerator *generator, int *position, unsigned int toWrite);
 static void handle_direct_mode(SemanticAnalyzer *analyzer, CodeGenerator *generator, Token *operand, InstructionOperandMemory *operandMemory, int *position);
-static void handle_register_mode(Token *operand, InstructionOperandMemory *operandMemory, bool isDst);
-static void handle_operand(SemanticAnalyzer *analyzer, CodeGenerator *generator, Token *operand, AddressingMode mode, InstructionOperandMemory *operandMemory, int *position, bool isDst);
+static void handle_register_mode(int regNum, InstructionOperandMemory *operandMemory, bool isDst);
+static void handle_operand(SemanticAnalyzer *analyzer, CodeGenerator *generator, Token *operand, int value, AddressingMode mode, InstructionOperandMemory *operandMemory, int *position, bool isDst);
 static void generate_instruction(CodeGenerator *generator, int *position, InstructionMemory instrucitionMemory);
 static void generate_operand_instruction(CodeGenerator *generator, int *position, InstructionOperandMemory operandMemory);
-static AddressingMode determine_addressing_mode(Token *operand_token, bool isDerefrenced);
-static unsigned int calculate_label_memory_size(LabelNode label);
+static unsigned int calculate_label_memory_size(InstructionTable *table, LabelNode label);
 
-void code_generator_initialize(CodeGenerator *generator, Lexer lexer) {
+void code_generator_initialize(CodeGenerator *generator, Lexer *lexer) {
     if (generator == NULL) {
         fprintf(stderr, "Error: Invalid parameters passed to code_generator_initialize\n");
         return;
@@ -48,7 +46,7 @@ void code_generator_initialize(CodeGenerator *generator, Lexer lexer) {
     generator->object_file = string_create();
 
     /* Assuming error_handler_initialize doesn't return a value */
-    error_handler_initialize(&generator->error_handler, lexer.source_code, lexer.file_path);
+    error_handler_initialize(&generator->error_handler, lexer->source_code, &lexer->line_index, lexer->file_path);
 }
 
 void code_generator_free(CodeGenerator *generator) {
@@ -88,7 +86,7 @@ void code_generator_update_labels(CodeGenerator *generator, TranslationUnit *uni
     /* Update instruction labels */
     currentLabel = unit->instruction_label_list;
     while (currentLabel != NULL) {
-        currentLabel->label.size = calculate_label_memory_size(currentLabel->label);
+        currentLabel->label.size = calculate_label_memory_size(&unit->instructions, currentLabel->label);
         currentLabel->label.position = currentPosition;
         currentPosition += currentLabel->label.size;
 
@@ -106,7 +104,7 @@ void code_generator_update_labels(CodeGenerator *generator, TranslationUnit *uni
     /* Update guidance labels */
     currentLabel = unit->guidance_label_list;
     while (currentLabel != NULL) {
-        currentLabel->label.size = calculate_label_memory_size(currentLabel->label);
+        currentLabel->label.size = calculate_label_memory_size(&unit->instructions, currentLabel->label);
         currentLabel->label.position = currentPosition;
         currentPosition += currentLabel->label.size;
 
@@ -137,17 +135,17 @@ void generate_entry_file_string(CodeGenerator *generator, SemanticAnalyzer *anal
     generator->entry_file = string_create();
 
     for (entryNodeList = unit->entry_list; entryNodeList != NULL; entryNodeList = entryNodeList->next) {
-        if (entryNodeList->entry_node.entry_label == NULL || entryNodeList->entry_node.entry_label->string.data ==
-            NULL) {
+        if (entryNodeList->entry_node.entry_label == NULL) {
             fprintf(stderr, "Error: Invalid entry node token\n");
             continue;
         }
 
-        identifierCell = semantic_analyzer_find_identifier(analyzer, entryNodeList->entry_node.entry_label->string);
+        identifierCell = semantic_analyzer_find_identifier(analyzer, *entryNodeList->entry_node.entry_label);
 
         if (identifierCell != NULL && !identifierCell->has_entry) {
             /* Add the name of entry */
-            string_append(&generator->entry_file, entryNodeList->entry_node.entry_label->string);
+            string_append_chars(&generator->entry_file, token_text(*entryNodeList->entry_node.entry_label, generator->error_handler.string),
+                                entryNodeList->entry_node.entry_label->length);
 
             /* Convert position to string and add to entry file */
             sprintf(positionBuffer, " %04u\n", identifierCell->value.label->position + STARTING_POSITION);
@@ -168,43 +166,28 @@ void generate_entry_file_string(CodeGenerator *generator, SemanticAnalyzer *anal
 
 void generate_object_and_external_files(CodeGenerator *generator,SemanticAnalyzer *analyzer,TranslationUnit *unit,
 int *instruction_lines,int *guidance_lines) {
-    /* Pointers to the label lists for instructions and guidance within the translation unit */
-    LabelNodeList *instructionLabelList = unit->instruction_label_list;
+    /* The guidance labels within the translation unit, the instructions are read from its table */
     LabelNodeList *guidanceLabelList = unit->guidance_label_list;
+    InstructionTable *instructionTable = &unit->instructions;
 
-    /* Initialize node lists for the current label's instructions and guidance */
-    InstructionNodeList *instructionNodeList = (instructionLabelList != NULL)
-                                                   ? instructionLabelList->label.instruction_list
-                                                   : NULL;
+    /* Initialize the node list for the current label's guidance */
     GuidanceNodeList *guidanceNodeList = (guidanceLabelList != NULL)
                                          ? guidanceLabelList->label.guidance_list
                                          : NULL;
 
     /* Initialize variables for generating code */
-    TokenReferenceNode *currentNumber = NULL;  /* Pointer to iterate through numbers in .data directives */
+    unsigned int currentNumber;  /* Index of the current number in a .data directive */
+    unsigned int row;  /* Index of the current instruction table row */
     int position = 100;  /* Memory position starts at 100 */
     int temp;  /* Temporary variable to store integer conversions */
     unsigned int toWrite = 0;  /* Variable to store binary data to write */
     char *buffer = NULL;  /* Temporary string buffer for formatting */
     int index;  /* Index variable for loops */
 
-    /* Process each instruction label in the list */
-    while (instructionLabelList != NULL) {
-        instructionNodeList = instructionLabelList->label.instruction_list;
-
-        /* Process each instruction node within the current label */
-        while (instructionNodeList != NULL) {
-            /* Generate and write the binary instruction data, updating the position */
-            generate_instruction_memory(generator, analyzer,
-                                        instructionNodeList->node,
-                                        &position);
-
-            /* Move to the next instruction node in the list */
-            instructionNodeList = instructionNodeList->next;
-        }
-
-        /* Move to the next instruction label in the list */
-        instructionLabelList = instructionLabelList->next;
+    /* Process every instruction row, the labels' rows follow each other in label order */
+    for (row = 0; row < instructionTable->count; row++) {
+        /* Generate and write the binary instruction data, updating the position */
+        generate_instruction_memory(generator, analyzer, instructionTable, unit->tokens.data, row, &position);
     }
 
     /* Calculate the number of instruction lines generated */
@@ -218,11 +201,9 @@ int *instruction_lines,int *guidance_lines) {
         while (guidanceNodeList != NULL) {
             /* Handle .data directives */
             if (guidanceNodeList->type == DATA_NODE) {
-                currentNumber = guidanceNodeList->node.dataNode.data_numbers;
-
                 /* Write each number in the .data directive to the object file */
-                while (currentNumber != NULL) {
-                    temp = atoi(currentNumber->token->string.data);  /* Convert string to integer */
+                for (currentNumber = 0; currentNumber < guidanceNodeList->node.dataNode.count; currentNumber++) {
+                    temp = guidanceNodeList->node.dataNode.numbers[currentNumber];  /* Already parsed and range checked */
                     toWrite = IntTo2Complement(temp);  /* Convert integer to 2's complement */
                     buffer = safe_calloc(10, sizeof(char));  /* Allocate buffer for formatting */
 
@@ -240,18 +221,16 @@ int *instruction_lines,int *guidance_lines) {
 
                     /* Increment the memory position */
                     position++;
-                    /* Move to the next number in the .data directive */
-                    currentNumber = currentNumber->next;
                 }
             }
             /* Handle .string directives */
             else /*if (guidanceNodeList->type == StringNodeKind)*/ {
                 /* Write each character of the string (excluding quotes) to the object file */
                 for (index = 1;  /* Start after the opening quote */
-                     index < string_length(guidanceNodeList->node.stringNode.string_label->string) - 1;
+                     index < (int) guidanceNodeList->node.stringNode.string_label->length - 1;
                      index++, position++) {  /* End before the closing quote */
 
-                    temp = (int) string_char_at(guidanceNodeList->node.stringNode.string_label->string, index);
+                    temp = (int) token_text(*guidanceNodeList->node.stringNode.string_label, generator->error_handler.string)[index];
                     toWrite = IntTo2Complement(temp);  /* Convert character to 2's complement */
                     buffer = safe_calloc(10, sizeof(char));  /* Allocate buffer for formatting */
 
@@ -424,18 +403,14 @@ static void write_to_object_file(CodeGenerator *generator, int *position, unsign
  * is being used as a source or destination. The ARE (Absolute/Relative/External)
  * field is set to indicate that this is a direct or indirect register addressing mode.
  *
- * @param operand A pointer to the Token struct representing the operand.
+ * @param regNum The register's number, as the lexer extracted it (e.g., 'r1' -> 1).
  * @param operandMemory A pointer to the InstructionOperandMemory struct to be populated.
  * @param isDst A boolean indicating if the operand is a destination (true) or source (false).
  */
-static void handle_register_mode(Token *operand, InstructionOperandMemory *operandMemory, bool isDst) {
-    int regNum;
+static void handle_register_mode(int regNum, InstructionOperandMemory *operandMemory, bool isDst) {
     /* Set ARE to 4 (binary 0b100) to indicate a register direct/indirect addressing mode */
     operandMemory->ARE = 4;
 
-    /* Extract the register number from the operand (e.g., 'r1' -> 1) */
-    regNum = atoi(operand->string.data + 1); /* Skip the 'r' character */
-
     /* Assign the register number to the appropriate field in operandMemory */
     if (isDst) {
         operandMemory->other.reg.rdst = regNum; /* Set destination register */
@@ -461,7 +436,7 @@ static void handle_register_mode(Token *operand, InstructionOperandMemory *opera
  */
 static void handle_direct_mode(SemanticAnalyzer *analyzer, CodeGenerator *generator, Token *operand, InstructionOperandMemory *operandMemory, int *position) {
     /* Look up the operand in the semantic analyzer to determine if it's a label or external symbol */
-    IdentifierCell *tempCellP = semantic_analyzer_find_identifier(analyzer, operand->string);
+    IdentifierCell *tempCellP = semantic_analyzer_find_identifier(analyzer, *operand);
     char *tempAtoiS;
 
     if (tempCellP != NULL) {
@@ -476,7 +451,7 @@ static void handle_direct_mode(SemanticAnalyzer *analyzer, CodeGenerator *genera
 
             /* Record the external reference in the external file with the current position */
             tempAtoiS = safe_calloc(10, sizeof(char));
-            string_append(&generator->external_file, operand->string);
+            string_append_chars(&generator->external_file, token_text(*operand, generator->error_handler.string), operand->length);
             sprintf(tempAtoiS, " %04d\n", *position + 1);
             string_append_cstr(&generator->external_file, tempAtoiS);
             free(tempAtoiS);
@@ -495,20 +470,18 @@ static void handle_direct_mode(SemanticAnalyzer *analyzer, CodeGenerator *genera
  * @param analyzer A pointer to the SemanticAnalyzer struct for symbol resolution.
  * @param generator A pointer to the CodeGenerator struct, which manages the output files.
  * @param operand A pointer to the Token struct representing the operand.
+ * @param value The operand's value from the instruction table: an immediate's value or a register's number.
  * @param mode The addressing mode of the operand.
  * @param operandMemory A pointer to the InstructionOperandMemory struct to be populated.
  * @param position A pointer to an integer representing the current memory position.
  * @param isDst A boolean indicating if the operand is a destination (true) or source (false).
  */
-static void handle_operand(SemanticAnalyzer *analyzer, CodeGenerator *generator, Token *operand, AddressingMode mode, InstructionOperandMemory *operandMemory, int *position, bool isDst) {
-    int temp;
-
+static void handle_operand(SemanticAnalyzer *analyzer, CodeGenerator *generator, Token *operand, int value, AddressingMode mode, InstructionOperandMemory *operandMemory, int *position, bool isDst) {
     switch (mode) {
         case ADDRESSING_MODE_IMMEDIATE:
             /* Handle immediate mode; set ARE to 4 (binary 0b100) and convert the value to 2's complement */
             operandMemory->ARE = 4;
-            temp = atoi(operand->string.data);
-            operandMemory->other.operand_value = IntTo2Complement(temp);
+            operandMemory->other.operand_value = IntTo2Complement(value);
             break;
 
         case ADDRESSING_MODE_DIRECT:
@@ -519,7 +492,7 @@ static void handle_operand(SemanticAnalyzer *analyzer, CodeGenerator *generator,
         case ADDRESSING_MODE_DIRECT_REGISTER:
         case ADDRESSING_MODE_INDIRECT_REGISTER:
             /* Handle register modes using the handle_register_mode function */
-            handle_register_mode(operand, operandMemory, isDst);
+            handle_register_mode(value, operandMemory, isDst);
             break;
 
         default:
@@ -572,13 +545,13 @@ static void generate_operand_instruction(CodeGenerator *generator, int *position
  * generate_instruction_memory
  *
  * This function generates the binary representation of a machine instruction
- * based on the provided operation and its operands. It handles the encoding
- * of the instruction into memory, determines the addressing modes of the operands,
- * and generates the corresponding memory for both the instruction and its operands.
+ * from its row in the instruction table. The row already holds the operation,
+ * the addressing modes of the operands and their values, so the instruction
+ * word is filled straight from it, followed by the memory of the operands.
  *
- * The function supports three cases:
+ * An absent operand has mode 0, which covers the three cases:
  * 1. Instructions with no operands (e.g., "stop").
- * 2. Instructions with one operand (e.g., "clr r3").
+ * 2. Instructions with one operand (e.g., "clr r3"), which is the destination.
  * 3. Instructions with two operands (e.g., "add r1, r2").
  *
  * The function updates the position counter as it writes the binary representation
@@ -587,117 +560,57 @@ static void generate_operand_instruction(CodeGenerator *generator, int *position
  *
  * @param generator A pointer to the CodeGenerator struct, which manages the output files.
  * @param analyzer A pointer to the SemanticAnalyzer struct, used for symbol resolution.
- * @param node The InstructionNode struct containing the operation and operands.
+ * @param table A pointer to the InstructionTable holding the instruction.
+ * @param tokens The token array the table's token indices refer to.
+ * @param row The instruction's row in the table.
  * @param position A pointer to an integer representing the current memory position.
  */
-static void generate_instruction_memory(CodeGenerator *generator,
-SemanticAnalyzer *analyzer,InstructionNode node,int *position) {
+static void generate_instruction_memory(CodeGenerator *generator, SemanticAnalyzer *analyzer,
+InstructionTable *table, Token *tokens, unsigned int row, int *position) {
 
-    /* Initialize the addressing modes for the first and second operands */
-    AddressingMode first = ADDRESSING_MODE_IMMEDIATE;
-    AddressingMode second = ADDRESSING_MODE_IMMEDIATE;
+    /* The addressing modes of the source and destination operands, 0 when absent */
+    AddressingMode source = (AddressingMode) table->source_mode[row];
+    AddressingMode destination = (AddressingMode) table->destination_mode[row];
 
     /* Initialize the instruction memory and operand memory structures to zero */
     InstructionMemory instrucitionMemory = {0};
     InstructionOperandMemory instrucitionFirstOperandMemory = {0};
     InstructionOperandMemory instrucitionSecondOperandMemory = {0};
 
-    /* Case 1: No operands (e.g., a simple operation like "stop") */
-    if (node.first_operand == NULL && node.second_operand == NULL) {
-        /* Set ARE to 4 (binary 0b100), indicating an absolute instruction */
-        instrucitionMemory.ARE = 4;
-        /* Set the instruction code based on the operation type */
-        instrucitionMemory.code = TokenTypeToInstrCode(node.operation->type);
-        /* Generate and write the instruction to memory */
-        generate_instruction(generator, position, instrucitionMemory);
-    }
-    /* Case 2: One operand (e.g., an operation like "clr r3") */
-    else if (node.first_operand != NULL && node.second_operand == NULL) {
-        /* Determine the addressing mode of the first operand */
-        first = determine_addressing_mode(node.first_operand, node.is_first_operand_derefrenced);
-        /* Set ARE to 4 (absolute), and assign the destination addressing mode */
-        instrucitionMemory.ARE = 4;
-        instrucitionMemory.dst = first;
-        /* Set the instruction code based on the operation type */
-        instrucitionMemory.code = TokenTypeToInstrCode(node.operation->type);
-        /* Generate and write the instruction to memory */
-        generate_instruction(generator, position, instrucitionMemory);
-
-        /* Handle the memory for the single operand */
-        handle_operand(analyzer, generator, node.first_operand, first, &instrucitionFirstOperandMemory, position, true);
-        /* Generate and write the operand's memory to the object file */
+    /* Set ARE to 4 (absolute), the operation code and the addressing modes */
+    instrucitionMemory.ARE = 4;
+    instrucitionMemory.code = (InstructionCode) table->opcode[row];
+    instrucitionMemory.src = source;
+    instrucitionMemory.dst = destination;
+    /* Generate and write the instruction to memory */
+    generate_instruction(generator, position, instrucitionMemory);
+
+    /* Special case: Both operands are registers */
+    if ((source == ADDRESSING_MODE_INDIRECT_REGISTER ||
+         source == ADDRESSING_MODE_DIRECT_REGISTER) &&
+        (destination == ADDRESSING_MODE_INDIRECT_REGISTER ||
+         destination == ADDRESSING_MODE_DIRECT_REGISTER)) {
+        /* Handle the memory for register operands (source and destination) */
+        handle_register_mode(table->source_value[row], &instrucitionFirstOperandMemory, false);
+        handle_register_mode(table->destination_value[row], &instrucitionFirstOperandMemory, true);
+        /* Generate and write the combined operand's memory to the object file */
         generate_operand_instruction(generator, position, instrucitionFirstOperandMemory);
+        return;
     }
-    /* Case 3: Two operands (e.g., an operation like "add r1, r2") */
-    else if (node.first_operand != NULL && node.second_operand != NULL) {
-        /* Determine the addressing modes of the first and second operands */
-        first = determine_addressing_mode(node.first_operand, node.is_first_operand_derefrenced);
-        second = determine_addressing_mode(node.second_operand, node.is_second_operand_derefrenced);
-        /* Set ARE to 4 (absolute), assign source and destination addressing modes */
-        instrucitionMemory.ARE = 4;
-        instrucitionMemory.dst = second;
-        instrucitionMemory.src = first;
-        /* Set the instruction code based on the operation type */
-        instrucitionMemory.code = TokenTypeToInstrCode(node.operation->type);
-        /* Generate and write the instruction to memory */
-        generate_instruction(generator, position, instrucitionMemory);
-
-        /* Special case: Both operands are registers */
-        if ((first == ADDRESSING_MODE_INDIRECT_REGISTER ||
-             first == ADDRESSING_MODE_DIRECT_REGISTER) &&
-            (second == ADDRESSING_MODE_INDIRECT_REGISTER ||
-             second == ADDRESSING_MODE_DIRECT_REGISTER)) {
-            /* Handle the memory for register operands (source and destination) */
-            handle_register_mode(node.first_operand, &instrucitionFirstOperandMemory, false);
-            handle_register_mode(node.second_operand, &instrucitionFirstOperandMemory, true);
-            /* Generate and write the combined operand's memory to the object file */
-            generate_operand_instruction(generator, position, instrucitionFirstOperandMemory);
-        } else {
-            /* Handle the first operand */
-            handle_operand(analyzer, generator, node.first_operand, first, &instrucitionFirstOperandMemory, position, false);
-            generate_operand_instruction(generator, position, instrucitionFirstOperandMemory);
 
-            /* Handle the second operand */
-            handle_operand(analyzer, generator, node.second_operand, second, &instrucitionSecondOperandMemory, position, true);
-            generate_operand_instruction(generator, position, instrucitionSecondOperandMemory);
-        }
+    /* Handle the source operand */
+    if (source != 0) {
+        handle_operand(analyzer, generator, &tokens[table->source_token[row]], table->source_value[row],
+                       source, &instrucitionFirstOperandMemory, position, false);
+        generate_operand_instruction(generator, position, instrucitionFirstOperandMemory);
     }
-}
 
-/**
- * determine_addressing_mode
- *
- * This function determines the addressing mode of a given operand based on its
- * token type and whether it is dereferenced. It supports immediate values,
- * identifiers (which are treated as direct addresses), and registers. For registers,
- * the function distinguishes between direct and indirect addressing modes based on
- * the `isDereferenced` flag.
- *
- * @param operand_token A pointer to the Token struct representing the operand.
- * @param isDerefrenced A boolean indicating if the operand is dereferenced (true) or not (false).
- * @return The determined AddressingMode for the operand.
- */
-static AddressingMode determine_addressing_mode(Token *operand_token, bool isDerefrenced) {
-    /* Check if the operand is a number (immediate value) */
-    if (operand_token->type == TOKEN_NUMBER) {
-        return ADDRESSING_MODE_IMMEDIATE; /* Return immediate addressing mode */
-    }
-    /* Check if the operand is an identifier (e.g., a variable or label) */
-    else if (operand_token->type == TOKEN_IDENTIFIER) {
-        return ADDRESSING_MODE_DIRECT; /* Return direct addressing mode */
+    /* Handle the destination operand */
+    if (destination != 0) {
+        handle_operand(analyzer, generator, &tokens[table->destination_token[row]], table->destination_value[row],
+                       destination, &instrucitionSecondOperandMemory, position, true);
+        generate_operand_instruction(generator, position, instrucitionSecondOperandMemory);
     }
-    /* Check if the operand is a register */
-    else if (operand_token->type == TOKEN_REGISTER) {
-        /* If the register is dereferenced, return indirect register addressing mode */
-        if (isDerefrenced) {
-            return ADDRESSING_MODE_INDIRECT_REGISTER;
-        }
-        /* Otherwise, return direct register addressing mode */
-        return ADDRESSING_MODE_DIRECT_REGISTER;
-    }
-
-    /* Default case (should not normally be reached) returns immediate addressing mode */
-    return ADDRESSING_MODE_IMMEDIATE;
 }
 
 /**
@@ -709,59 +622,37 @@ static AddressingMode determine_addressing_mode(Token *operand_token, bool isDer
  * instructions and data. The function accounts for the size of instructions, operands,
  * and any string or data guidance nodes.
  *
+ * @param table A pointer to the InstructionTable holding the label's instruction rows.
  * @param label A LabelNode struct representing the label for which to calculate the memory size.
  * @return The total number of memory words required for the label.
  */
-static unsigned int calculate_label_memory_size(LabelNode label) {
-    /* Pointers to the instruction and guidance node lists associated with the label */
-    InstructionNodeList *instructionNodeList = label.instruction_list;
+static unsigned int calculate_label_memory_size(InstructionTable *table, LabelNode label) {
+    /* The guidance node list associated with the label */
     GuidanceNodeList *guidanceNodeList = label.guidance_list;
-    TokenReferenceNode *numbers = NULL; /* Pointer to iterate over data numbers in guidance nodes */
 
-    /* Initialize addressing modes for operands (default to immediate mode) */
-    AddressingMode first = ADDRESSING_MODE_IMMEDIATE;
-    AddressingMode second = ADDRESSING_MODE_IMMEDIATE;
+    /* Addressing modes of the operands, 0 when absent */
+    AddressingMode source;
+    AddressingMode destination;
+    unsigned int row;
 
     /* Initialize the output size to 0 */
     int totalSize = 0;
 
-    /* Iterate through all instructions associated with the label */
-    while (instructionNodeList != NULL) {
+    /* Iterate through the label's instruction rows */
+    for (row = label.first_instruction; row < label.first_instruction + label.instruction_count; row++) {
         totalSize++; /* Add 1 for the memory instruction itself */
 
-        /* Reset addressing modes to immediate for each instruction */
-        first = ADDRESSING_MODE_IMMEDIATE;
-        second = ADDRESSING_MODE_IMMEDIATE;
-
-        /* Determine addressing mode for the first operand, if it exists */
-        if (instructionNodeList->node.first_operand != NULL) {
-            first = determine_addressing_mode(instructionNodeList->node.first_operand,
-                                                instructionNodeList->node.is_first_operand_derefrenced);
-        }
-
-        /* Determine addressing mode for the second operand, if it exists */
-        if (instructionNodeList->node.second_operand != NULL) {
-            second = determine_addressing_mode(instructionNodeList->node.second_operand,
-                                                 instructionNodeList->node.is_second_operand_derefrenced);
-        }
+        source = (AddressingMode) table->source_mode[row];
+        destination = (AddressingMode) table->destination_mode[row];
 
         /* Special case: both operands are registers that can fit in one memory word */
-        if ((first == ADDRESSING_MODE_INDIRECT_REGISTER || first == ADDRESSING_MODE_DIRECT_REGISTER) &&
-            (second == ADDRESSING_MODE_INDIRECT_REGISTER || second == ADDRESSING_MODE_DIRECT_REGISTER)) {
+        if ((source == ADDRESSING_MODE_INDIRECT_REGISTER || source == ADDRESSING_MODE_DIRECT_REGISTER) &&
+            (destination == ADDRESSING_MODE_INDIRECT_REGISTER || destination == ADDRESSING_MODE_DIRECT_REGISTER)) {
             totalSize++; /* Add 1 for the combined register operands */
         } else {
-            /* Add memory for the first operand, if it exists */
-            if (instructionNodeList->node.first_operand != NULL) {
-                totalSize++;
-            }
-            /* Add memory for the second operand, if it exists */
-            if (instructionNodeList->node.second_operand != NULL) {
-                totalSize++;
-            }
+            /* Add memory for each operand that exists */
+            totalSize += (source != 0) + (destination != 0);
         }
-
-        /* Move to the next instruction in the list */
-        instructionNodeList = instructionNodeList->next;
     }
 
     /* Iterate through all guidance nodes associated with the label */
@@ -769,17 +660,13 @@ static unsigned int calculate_label_memory_size(LabelNode label) {
         /* Handle string guidance nodes */
         if (guidanceNodeList->type == STRING_NODE) {
             /* Add the length of the string plus one for the null terminator, minus two for the quotes */
-            totalSize += string_length(guidanceNodeList->node.stringNode.string_label->string) + 1 - 2;
+            totalSize += guidanceNodeList->node.stringNode.string_label->length + 1 - 2;
         }
 
         /* Handle data guidance nodes (e.g., .data) */
         if (guidanceNodeList->type == DATA_NODE) {
-            numbers = guidanceNodeList->node.dataNode.data_numbers;
-            /* Iterate through all numbers in the data node and add 1 for each */
-            while (numbers != NULL) {
-                totalSize++; /* Each number occupies one memory word */
-                numbers = numbers->next;
-            }
+            /* Each number occupies one memory word */
+            totalSize += guidanceNodeList->node.dataNode.count;
         }
 
         /* Move to the next guidance node in the list */
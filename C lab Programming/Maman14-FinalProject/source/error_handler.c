@@ -3,24 +3,103 @@
 
 #define RED_COLOR   "\x1B[1;91m"  /* Define the red color for terminal output */
 #define RESET_COLOR "\x1B[0m"  /* Define the reset color for terminal output */
+#define INITIAL_LINE_CAPACITY 64  /* Number of line starts allocated the first time one is recorded */
+#define INITIAL_CALL_CAPACITY 16  /* Number of macro calls allocated the first time one is recorded */
 
 /* Function prototype to count digits in an integer */
 static int count_digits(int value);
-/* Function prototype to get the line number from a string */
-static unsigned int string_get_line_number(String str, unsigned int index);
-/* Function prototype to find the start of a line in a string */
-static unsigned int string_find_line_start(String str, unsigned int index);
+/* Function prototype to check whether the source line of an offset can be shown */
+static bool error_handler_has_line(ErrorHandler * handler, unsigned int index);
 /* Function prototype to print an error pointer */
 static void print_error_pointer(unsigned int lineNumber, unsigned int errorIndex, unsigned int errorLength);
 /* Function prototype to print an error line */
-static void print_error_line(String sourceString, unsigned int startIndex, unsigned int errorIndex, unsigned int errorLength);
+static void print_error_line(String sourceString, LineIndex lineIndex, unsigned int errorIndex, unsigned int errorLength, unsigned int shownLine);
+/* Function prototype to find the file an offset was read from */
+static const char *find_file_line(ErrorHandler * handler, unsigned int offset, unsigned int *line);
 /* Function prototype to print the error location */
 static void print_error_location(const char *filePath, int line, int column);
+/* Function prototype to print the macro call a token was spliced in by */
+static void print_expansion_note(ErrorHandler * handler, Token token);
 
-void error_handler_initialize(ErrorHandler * handler, String source_string, char * filePath){
+void line_index_initialize(LineIndex * index){
+    index->starts = NULL;  /* Nothing is allocated until the first line is recorded */
+    index->count = 0;
+    index->capacity = 0;
+    index->calls = NULL;  /* Nor until the first macro call is */
+    index->call_count = 0;
+    index->call_capacity = 0;
+    index->regions = NULL;  /* Nor until another file is appended */
+    index->region_count = 0;
+}
+
+void line_index_add(LineIndex * index, unsigned int offset){
+    if (index->count > 0 && offset <= index->starts[index->count - 1]) return;  /* Keep the starts sorted and unique */
+
+    if (index->count == index->capacity) {  /* Grow geometrically so recording stays amortized O(1) */
+        index->capacity = (index->capacity == 0) ? INITIAL_LINE_CAPACITY : index->capacity * 2;
+        index->starts = safe_realloc(index->starts, index->capacity * sizeof(unsigned int));
+    }
+    index->starts[index->count++] = offset;
+}
+
+unsigned int line_index_find_line(LineIndex index, unsigned int offset){
+    unsigned int low = 0;  /* Lines before low start at or before the offset */
+    unsigned int high = index.count;  /* Lines from high on start after the offset */
+    unsigned int middle;
+
+    while (low < high) {  /* Find the first line that starts after the offset */
+        middle = low + (high - low) / 2;
+        if (index.starts[middle] <= offset) low = middle + 1;
+        else high = middle;
+    }
+    return low == 0 ? 1 : low;  /* The offset is on the line before it */
+}
+
+unsigned int line_index_find_column(LineIndex index, unsigned int offset){
+    if (index.count == 0) return offset;  /* Without line starts the whole source is one line */
+    return offset - index.starts[line_index_find_line(index, offset) - 1];
+}
+
+unsigned int line_index_add_call(LineIndex * index, Token call){
+    if (index->call_count >= TOKEN_MAX_EXPANSION) return 0;  /* The number would not fit a token */
+
+    if (index->call_count == index->call_capacity) {  /* Grow geometrically so recording stays amortized O(1) */
+        index->call_capacity = (index->call_capacity == 0) ? INITIAL_CALL_CAPACITY : index->call_capacity * 2;
+        index->calls = safe_realloc(index->calls, index->call_capacity * sizeof(Token));
+    }
+    index->calls[index->call_count++] = call;
+    return index->call_count;  /* Numbers start from 1, 0 is a token written in place */
+}
+
+void line_index_add_region(LineIndex * index, unsigned int base, const char * file_path){
+    SourceRegion *region;
+
+    index->regions = safe_realloc(index->regions, (index->region_count + 1) * sizeof(SourceRegion));  /* Only a few files are ever appended */
+    region = &index->regions[index->region_count++];
+    region->base = base;
+    region->first_line = index->count;  /* The region's first line start is the next one recorded */
+    region->file_path = safe_malloc(strlen(file_path) + 1);
+    strcpy(region->file_path, file_path);
+}
+
+void line_index_free(LineIndex * index){
+    unsigned int i;
+
+    free(index->starts);  /* Free the line starts */
+    free(index->calls);  /* Free the macro calls */
+    for (i = 0; i < index->region_count; i++) {
+        free(index->regions[i].file_path);  /* Free the regions' paths */
+    }
+    free(index->regions);  /* Free the regions */
+    line_index_initialize(index);
+}
+
+void error_handler_initialize(ErrorHandler * handler, String source_string, const LineIndex * line_index, char * filePath){
     handler->string = source_string;  /* Initialize the source string in the error handler */
+    handler->line_index = line_index;  /* Share the line starts of the source */
     handler->file_path = filePath;  /* Initialize the file path in the error handler */
     handler->error_list = NULL;  /* Initialize the error list to NULL */
+    handler->error_tail = NULL;  /* An empty list has no last error */
 }
 
 void error_handler_add_token_error(ErrorHandler * handler, ErrorSource source, TokenError error){
@@ -33,12 +112,9 @@ void error_handler_add_token_error(ErrorHandler * handler, ErrorSource source, T
     if (handler->error_list == NULL) {  /* If the error list is empty */
         handler->error_list = newError;  /* Set the new error as the first error */
     } else {  /* If the error list is not empty */
-        ErrorNode *current = handler->error_list;  /* Get the current error node */
-        while (current->next != NULL) {  /* Traverse to the end of the error list */
-            current = current->next;  /* Move to the next error node */
-        }
-        current->next = newError;  /* Add the new error to the end of the list */
+        handler->error_tail->next = newError;  /* Add the new error to the end of the list */
     }
+    handler->error_tail = newError;  /* The new error is the last one */
 }
 
 void error_handler_add_char_error(ErrorHandler * handler, ErrorSource source, CharError error){
@@ -51,12 +127,31 @@ void error_handler_add_char_error(ErrorHandler * handler, ErrorSource source, Ch
     if (handler->error_list == NULL) {  /* If the error list is empty */
         handler->error_list = newError;  /* Set the new error as the first error */
     } else {  /* If the error list is not empty */
-        ErrorNode *current = handler->error_list;  /* Get the current error node */
-        while (current->next != NULL) {  /* Traverse to the end of the error list */
-            current = current->next;  /* Move to the next error node */
+        handler->error_tail->next = newError;  /* Add the new error to the end of the list */
+    }
+    handler->error_tail = newError;  /* The new error is the last one */
+}
+
+void error_handler_take_errors(ErrorHandler * handler, ErrorHandler * other){
+    ErrorNode *current;  /* The error being placed */
+
+    for (current = other->error_list; current != NULL; current = current->next) {  /* Place char errors by this handler's lines */
+        if (current->type == CHAR_ERROR_TYPE) {
+            current->error.charError.lineNumber = line_index_find_line(*handler->line_index, current->error.charError.fileIndex);
+            current->error.charError.lineIndex = line_index_find_column(*handler->line_index, current->error.charError.fileIndex);
         }
-        current->next = newError;  /* Add the new error to the end of the list */
     }
+
+    if (other->error_list == NULL) return;  /* Nothing to take, the tail stays */
+
+    if (handler->error_list == NULL) {  /* Hang the other list on this one as a whole */
+        handler->error_list = other->error_list;
+    } else {
+        handler->error_tail->next = other->error_list;
+    }
+    handler->error_tail = other->error_tail;
+    other->error_list = NULL;
+    other->error_tail = NULL;
 }
 
 void error_handler_report_errors(ErrorHandler * handler){
@@ -76,22 +171,28 @@ void error_handler_report_errors(ErrorHandler * handler){
         switch (current->type) {  /* Switch based on the error type */
             case TOKEN_ERROR_TYPE: {  /* If the error type is token error */
                 TokenError *error = &current->error.tokenError;  /* Get the token error */
-                unsigned int startIndex = string_find_line_start(handler->string, error->token.index);  /* Find the start of the error line */
-                printf("Debug: Token Error - Line: %d, IndexInLine: %d, Index: %d\n", error->token.line, error->token.index_in_line, error->token.index);  /* Print debug information */
-                print_error_location(handler->file_path, error->token.line, error->token.index_in_line + 1);  /* Print the error location */
+                unsigned int line;  /* Tokens don't store their line */
+                const char *file_path = find_file_line(handler, error->token.index, &line);  /* Nor the file they were read from */
+                unsigned int column = line_index_find_column(*handler->line_index, error->token.index);  /* Nor their column */
+                printf("Debug: Token Error - Line: %d, IndexInLine: %d, Index: %d\n", line, column, error->token.index);  /* Print debug information */
+                print_error_location(file_path, line, column + 1);  /* Print the error location */
                 printf("%s%s%s: %s\n", RED_COLOR, error_type, RESET_COLOR, error->message.data);  /* Print the error message */
-                print_error_line(handler->string, startIndex, error->token.index, string_length(error->token.string));  /* Print the error line */
-                print_error_pointer(error->token.line, error->token.index_in_line, string_length(error->token.string));  /* Print the error pointer */
+                if (error_handler_has_line(handler, error->token.index)) {  /* A streamed source isn't held, so there is no line to show */
+                    print_error_line(handler->string, *handler->line_index, error->token.index, error->token.length, line);  /* Print the error line */
+                    print_error_pointer(line, column, error->token.length);  /* Print the error pointer */
+                }
+                print_expansion_note(handler, error->token);  /* Name the call a body token was spliced in by */
                 break;
             }
             case CHAR_ERROR_TYPE: {  /* If the error type is char error */
                 CharError *error = &current->error.charError;  /* Get the char error */
-                unsigned int startIndex = string_find_line_start(handler->string, error->fileIndex);  /* Find the start of the error line */
                 printf("Debug: Char Error - Line: %d, LineIndex: %d, Index: %d\n", error->lineNumber, error->lineIndex, error->fileIndex);  /* Print debug information */
                 print_error_location(handler->file_path, error->lineNumber, error->lineIndex + 1);  /* Print the error location */
                 printf("%s%s%s: %s\n", RED_COLOR, error_type, RESET_COLOR, error->message.data);  /* Print the error message */
-                print_error_line(handler->string, startIndex, error->fileIndex, 1);  /* Print the error line */
-                print_error_pointer(error->lineNumber, error->lineIndex, 1);  /* Print the error pointer */
+                if (error_handler_has_line(handler, error->fileIndex)) {  /* A streamed source isn't held, so there is no line to show */
+                    print_error_line(handler->string, *handler->line_index, error->fileIndex, 1, error->lineNumber);  /* Print the error line */
+                    print_error_pointer(error->lineNumber, error->lineIndex, 1);  /* Print the error pointer */
+                }
                 break;
             }
             default:
@@ -140,9 +241,39 @@ static void print_error_location(const char *filePath, int line, int column) {
     printf("%s:%d:%d: ", filePath, line, column);  /* Print the error location */
 }
 
-static void print_error_line(String sourceString, unsigned int startIndex, unsigned int errorIndex, unsigned int errorLength) {
+static void print_expansion_note(ErrorHandler * handler, Token token) {
+    Token call;
+    unsigned int line;
+    const char *file_path;
+
+    if (token.expansion == 0 || token.expansion > handler->line_index->call_count) return;  /* Written in place */
+    call = handler->line_index->calls[token.expansion - 1];  /* The call's identifier, where the call was written */
+    file_path = find_file_line(handler, call.index, &line);
+    print_error_location(file_path, line, line_index_find_column(*handler->line_index, call.index) + 1);  /* Print the call's location */
+    printf("note: in expansion of macro %.*s\n", (int) call.length, handler->string.data + call.index);  /* Name the macro */
+}
+
+static const char *find_file_line(ErrorHandler * handler, unsigned int offset, unsigned int *line) {
+    unsigned int i = handler->line_index->region_count;  /* The regions after the offset are passed from the last */
+
+    *line = line_index_find_line(*handler->line_index, offset);  /* The line in the whole source */
+    while (i > 0 && handler->line_index->regions[i - 1].base > offset) {
+        i--;
+    }
+    if (i == 0) return handler->file_path;  /* The offset is in the file's own text */
+    *line -= handler->line_index->regions[i - 1].first_line;  /* Numbered from the region's first line */
+    return handler->line_index->regions[i - 1].file_path;
+}
+
+static bool error_handler_has_line(ErrorHandler * handler, unsigned int index) {
+    return index < handler->string.length && handler->line_index->count > 0;  /* Both the text and the line starts are needed */
+}
+
+static void print_error_line(String sourceString, LineIndex lineIndex, unsigned int errorIndex, unsigned int errorLength, unsigned int shownLine) {
     unsigned int i;
-    printf("    %d | ", string_get_line_number(sourceString, startIndex));  /* Print the line number */
+    unsigned int lineNumber = line_index_find_line(lineIndex, errorIndex);  /* Find the error line */
+    unsigned int startIndex = lineIndex.starts[lineNumber - 1];  /* Find the start of the error line */
+    printf("    %d | ", shownLine);  /* Print the line number in the file the line was read from */
     for (i = startIndex; string_char_at(sourceString, i) != '\0' && string_char_at(sourceString, i) != '\n'; i++) {  /* Loop through the line */
         if (i == errorIndex) printf("%s", RED_COLOR);  /* Print the error in red */
         putchar(string_char_at(sourceString, i));  /* Print the character */
@@ -161,21 +292,3 @@ static void print_error_pointer(unsigned int lineNumber, unsigned int errorIndex
     }
     printf("%s\n", RESET_COLOR);  /* Reset the color */
 }
-
-static unsigned int string_find_line_start(String str, unsigned int index) {
-    while (index > 0 && string_char_at(str, index - 1) != '\n') {  /* Loop until the start of the line */
-        index--;  /* Decrement the index */
-    }
-    return index;  /* Return the start index */
-}
-
-static unsigned int string_get_line_number(String str, unsigned int index) {
-    unsigned int i;
-    unsigned int line = 1;  /* Initialize the line number */
-    for (i = 0; i < index; i++) {  /* Loop through the string */
-        if (string_char_at(str, i) == '\n') {  /* If a newline is found */
-            line++;  /* Increment the line number */
-        }
-    }
-    return line;  /* Return the line number */
-}
@@ -1,3 +1,8 @@
+/* Chunked lexing runs its chunks on POSIX threads when built with -DLEXER_THREADS (and -pthread) */
+#ifdef LEXER_THREADS
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "../headers/error_handler.h"
 #include "../headers/lexer.h"
 #include "../headers/safe_allocations.h"
@@ -8,13 +13,259 @@
 #include <ctype.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
+#ifdef LEXER_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+/* Vector scanning kernels are built on x86 GCC/Clang and picked at run time, -DLEXER_NO_SIMD keeps only the scalar one */
+#if !defined(LEXER_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define LEXER_X86_SIMD
+#include <immintrin.h>
+#endif
 
 #define RED_COLOR   "\x1B[1;91m"
 #define RESET_COLOR "\x1B[0m"
 
+#define INITIAL_TOKEN_CAPACITY 64
+
+#define LONE_SIGN_MESSAGE "it seems that you have a ' - ' or ' + ' without any numerical chars after it"
+#define UNCLOSED_STRING_MESSAGE "There is no string after \""
+#define UNKNOWN_DIRECTIVE_MESSAGE "Unknown non-operative instruction"
+#define UNKNOWN_CHAR_MESSAGE "unknown char (in the current context)"
+#define TOKEN_TOO_LONG_MESSAGE "token is longer than the stream buffer"
+#define SOURCE_TOO_LARGE_MESSAGE "source is too large, the rest of the file is ignored"
+
+#define STREAM_MIN_CAPACITY 16
+
+#define MAX_LEXER_THREADS 16
+#define MIN_CHUNK_SIZE (256 * 1024) /* Smaller chunks cost more in thread start-up and joining than they save */
+
+/* A token is four words (type, offset, length and payload), the array of them is most of the lexer's memory */
+typedef char token_size_check[(sizeof(Token) <= 16) ? 1 : -1];
+
+/* Reserved word lookup, a perfect hash over every register, instruction, macro keyword and directive.
+ * The hash mixes the first two characters, the last character and the length, and the constants were
+ * picked so no two reserved words share a slot. Any word is classified with one hash and one compare. */
+#define RESERVED_WORD_SLOTS 64
+
+typedef struct ReservedWord {
+    const char *text; /* The reserved spelling ("" for an empty slot) */
+    unsigned int length; /* Length of text (0 for an empty slot) */
+    TokenType type; /* Token type a matching word is given */
+} ReservedWord;
+
+static const ReservedWord reserved_words[RESERVED_WORD_SLOTS] = {
+    {"endmacr", 7, TOKEN_ENDMACR},
+    {"stop", 4, TOKEN_STOP},
+    {"cmp", 3, TOKEN_CMP},
+    {"", 0, TOKEN_IDENTIFIER},
+    {".data", 5, TOKEN_DATA_INS},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"r1", 2, TOKEN_REGISTER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"mov", 3, TOKEN_MOV},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"r4", 2, TOKEN_REGISTER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"r7", 2, TOKEN_REGISTER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"bne", 3, TOKEN_BNE},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {".extern", 7, TOKEN_EXTERN_INS},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"macr", 4, TOKEN_MACR},
+    {"sub", 3, TOKEN_SUB},
+    {"inc", 3, TOKEN_INC},
+    {"r2", 2, TOKEN_REGISTER},
+    {"red", 3, TOKEN_RED},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {".string", 7, TOKEN_STRING_INS},
+    {"r5", 2, TOKEN_REGISTER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {".include", 8, TOKEN_INCLUDE_INS},
+    {"add", 3, TOKEN_ADD},
+    {"not", 3, TOKEN_NOT},
+    {"dec", 3, TOKEN_DEC},
+    {"jsr", 3, TOKEN_JSR},
+    {"clr", 3, TOKEN_CLR},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"r0", 2, TOKEN_REGISTER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"jmp", 3, TOKEN_JMP},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"r3", 2, TOKEN_REGISTER},
+    {"lea", 3, TOKEN_LEA},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"rts", 3, TOKEN_RTS},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"r6", 2, TOKEN_REGISTER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"", 0, TOKEN_IDENTIFIER},
+    {"prn", 3, TOKEN_PRN},
+    {"", 0, TOKEN_IDENTIFIER},
+    {".entry", 6, TOKEN_ENTRY_INS}
+};
+
+/* Character classes of the scanner, every byte value maps to exactly one class */
+typedef enum CharClass {
+    CLASS_INVALID, /* a char that can't start or continue any token */
+    CLASS_END, /* the null terminator of the source buffer */
+    CLASS_EOF, /* the EOF sentinel appended to the source */
+    CLASS_SPACE, /* ' ', '\t' and '\r' */
+    CLASS_NEWLINE, /* '\n' */
+    CLASS_SEMICOLON, /* ';' (starts a comment) */
+    CLASS_SEPARATOR, /* ',', ':', '#' and '*' */
+    CLASS_SIGN, /* '+' and '-' */
+    CLASS_DIGIT, /* '0' - '9' */
+    CLASS_QUOTE, /* '"' */
+    CLASS_DOT, /* '.' (starts a directive) */
+    CLASS_LETTER, /* 'a' - 'z' and 'A' - 'Z' */
+    CLASS_UNDERSCORE, /* '_' (starts a macro identifier) */
+    CLASS_COUNT
+} CharClass;
+
+/* States of the scanner DFA, STATE_DONE means the current token ends before the char being looked at */
+typedef enum ScanState {
+    STATE_START,
+    STATE_IDENTIFIER,
+    STATE_MACRO_IDENTIFIER,
+    STATE_SIGN,
+    STATE_NUMBER,
+    STATE_DIRECTIVE,
+    STATE_STRING,
+    STATE_STRING_CLOSED,
+    STATE_COMMENT,
+    STATE_SEPARATOR,
+    STATE_NEWLINE,
+    STATE_EOF,
+    STATE_INVALID,
+    STATE_DONE
+} ScanState;
+
+static const unsigned char char_classes[256] = {
+    CLASS_END, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0x00 - 0x07 */
+    CLASS_INVALID, CLASS_SPACE, CLASS_NEWLINE, CLASS_INVALID, CLASS_INVALID, CLASS_SPACE, CLASS_INVALID, CLASS_INVALID, /* 0x08 - 0x0F */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0x10 - 0x17 */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0x18 - 0x1F */
+    CLASS_SPACE, CLASS_INVALID, CLASS_QUOTE, CLASS_SEPARATOR, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0x20 - 0x27 */
+    CLASS_INVALID, CLASS_INVALID, CLASS_SEPARATOR, CLASS_SIGN, CLASS_SEPARATOR, CLASS_SIGN, CLASS_DOT, CLASS_INVALID, /* 0x28 - 0x2F */
+    CLASS_DIGIT, CLASS_DIGIT, CLASS_DIGIT, CLASS_DIGIT, CLASS_DIGIT, CLASS_DIGIT, CLASS_DIGIT, CLASS_DIGIT, /* 0x30 - 0x37 */
+    CLASS_DIGIT, CLASS_DIGIT, CLASS_SEPARATOR, CLASS_SEMICOLON, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0x38 - 0x3F */
+    CLASS_INVALID, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, /* 0x40 - 0x47 */
+    CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, /* 0x48 - 0x4F */
+    CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, /* 0x50 - 0x57 */
+    CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_UNDERSCORE, /* 0x58 - 0x5F */
+    CLASS_INVALID, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, /* 0x60 - 0x67 */
+    CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, /* 0x68 - 0x6F */
+    CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, /* 0x70 - 0x77 */
+    CLASS_LETTER, CLASS_LETTER, CLASS_LETTER, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0x78 - 0x7F */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0x80 - 0x87 */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0x88 - 0x8F */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0x90 - 0x97 */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0x98 - 0x9F */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xA0 - 0xA7 */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xA8 - 0xAF */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xB0 - 0xB7 */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xB8 - 0xBF */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xC0 - 0xC7 */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xC8 - 0xCF */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xD0 - 0xD7 */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xD8 - 0xDF */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xE0 - 0xE7 */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xE8 - 0xEF */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, /* 0xF0 - 0xF7 */
+    CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_INVALID, CLASS_EOF /* 0xF8 - 0xFF */
+};
+
+/* Next state for every (state, class) pair. The START row picks the token kind from its first char */
+static const unsigned char scan_transitions[STATE_DONE][CLASS_COUNT] = {
+    /* START */
+    {STATE_INVALID, STATE_DONE, STATE_EOF, STATE_START, STATE_NEWLINE, STATE_COMMENT, STATE_SEPARATOR, STATE_SIGN, STATE_NUMBER, STATE_STRING, STATE_DIRECTIVE, STATE_IDENTIFIER, STATE_MACRO_IDENTIFIER},
+    /* IDENTIFIER */
+    {STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_IDENTIFIER, STATE_DONE, STATE_DONE, STATE_IDENTIFIER, STATE_DONE},
+    /* MACRO_IDENTIFIER */
+    {STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_MACRO_IDENTIFIER, STATE_DONE, STATE_DONE, STATE_MACRO_IDENTIFIER, STATE_MACRO_IDENTIFIER},
+    /* SIGN */
+    {STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_NUMBER, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE},
+    /* NUMBER */
+    {STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_NUMBER, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE},
+    /* DIRECTIVE */
+    {STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DIRECTIVE, STATE_DONE},
+    /* STRING */
+    {STATE_STRING, STATE_DONE, STATE_DONE, STATE_STRING, STATE_STRING, STATE_STRING, STATE_STRING, STATE_STRING, STATE_STRING, STATE_STRING_CLOSED, STATE_STRING, STATE_STRING, STATE_STRING},
+    /* STRING_CLOSED */
+    {STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE},
+    /* COMMENT */
+    {STATE_COMMENT, STATE_DONE, STATE_DONE, STATE_COMMENT, STATE_DONE, STATE_COMMENT, STATE_COMMENT, STATE_COMMENT, STATE_COMMENT, STATE_COMMENT, STATE_COMMENT, STATE_COMMENT, STATE_COMMENT},
+    /* SEPARATOR */
+    {STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE},
+    /* NEWLINE */
+    {STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE},
+    /* EOF */
+    {STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE},
+    /* INVALID */
+    {STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE, STATE_DONE}
+};
+
+/* One piece of a source lexed on its own, a view of the parent lexer's source with its own tokens, line starts and errors */
+typedef struct LexerChunk {
+    Lexer lexer; /* Lexes the chunk, starting in the first column of a line */
+    unsigned int start; /* Offset of the first char of the chunk */
+    unsigned int end; /* Offset one past the chunk's last char (its last token may run past it) */
+#ifdef LEXER_THREADS
+    pthread_t thread; /* The thread lexing the chunk */
+    bool threaded; /* The thread was started (otherwise the chunk is lexed when it is joined) */
+#endif
+} LexerChunk;
+
+/*
+ * Scans forward from cursor and returns the first byte that is (stop_on_match) or is not (!stop_on_match)
+ * one of the three given bytes, or end if there is none. Bytes at end and past it are never read.
+ */
+typedef const char *(*ByteScanner)(const char *cursor, const char *end, char first, char second, char third, bool stop_on_match);
+
 static char* safe_strdup(const char* str);
 static void add_token(Lexer * lexer, Token token);
+static void append_tokens(TokenArray *array, const Token *tokens, unsigned int count);
+static void scan_range(Lexer *lexer, const char *stop);
+static void terminate_token_stream(Lexer *lexer);
+static unsigned int cut_chunks(Lexer *lexer, LexerChunk *chunks, unsigned int chunk_count);
+static void *lex_chunk(void *chunk);
+static void join_chunk(Lexer *lexer, LexerChunk *chunk);
+static void token_array_initialize(TokenArray *array);
+static String read_source(FILE *file, size_t expected_size, size_t *bytes_read);
 static bool is_valid_macro_char(char ch);
+static TokenType classify_reserved_word(const char *text, unsigned int length, TokenType fallback);
+static TokenType separator_token_type(char ch);
+static void report_char_error(ErrorHandler *handler, char ch, Token token, const char *message);
+static void report_token_error(ErrorHandler *handler, Token token, const char *message);
+static void report_stream_error(LexerStream *stream, char ch, const char *message);
+static void set_token_value(Token *token, const char *text);
+static size_t drop_nul_bytes(char *data, size_t count);
+static bool stream_fill(LexerStream *stream);
+static char stream_char_at(LexerStream *stream, unsigned long offset);
+static ByteScanner select_byte_scanner(void);
+static const char *scan_bytes_scalar(const char *cursor, const char *end, char first, char second, char third, bool stop_on_match);
+static const char *source_end(Lexer *lexer);
+static void lexer_skip_to(Lexer *lexer, const char *target);
+static void lexer_initialize_line_index(Lexer *lexer);
 
 
 void lexer_initialize_from_cstr(Lexer * lexer, char * source_string){
@@ -25,9 +276,12 @@ void lexer_initialize_from_cstr(Lexer * lexer, char * source_string){
     lexer->line_number = 1;
 
     lexer->file_path = safe_strdup("from_string.as");
-    lexer->token_list = NULL;
+    token_array_initialize(&lexer->tokens);
+    lexer->macro_count = 0;
+    lexer->include_count = 0;
 
-    error_handler_initialize(&lexer->error_handler, lexer->source_code, lexer->file_path);
+    lexer_initialize_line_index(lexer);
+    error_handler_initialize(&lexer->error_handler, lexer->source_code, &lexer->line_index, lexer->file_path);
 
     /* Append EOF to ensure consistent end-of-input handling */
     string_append_char(&lexer->source_code, EOF);
@@ -35,31 +289,57 @@ void lexer_initialize_from_cstr(Lexer * lexer, char * source_string){
 
 bool lexer_initialize_from_file(Lexer *lexer, char * file_path){
     FILE *file;
-    int ch;
+    long file_size;
+    size_t bytes_read;
     char *full_path;
 
-    lexer->source_code = string_create();
     full_path = safe_malloc(strlen(file_path) + 4); /* +4 for ".as" and null terminator*/
     sprintf(full_path, "%s.as", file_path);
     lexer->file_path = full_path;
 
-    lexer->token_list = NULL;
-
-    error_handler_initialize(&lexer->error_handler, lexer->source_code, lexer->file_path);
+    token_array_initialize(&lexer->tokens);
+    lexer->macro_count = 0;
+    lexer->include_count = 0;
 
     file = fopen(lexer->file_path, "r");
     if (file == NULL) {
+        lexer->source_code = string_create();
+        lexer_initialize_line_index(lexer);
+        error_handler_initialize(&lexer->error_handler, lexer->source_code, &lexer->line_index, lexer->file_path);
         fprintf(stderr, "%sLexer Error:%s Couldn't open \"%s\".\n", RED_COLOR, RESET_COLOR, lexer->file_path);
         return false;
     }
 
-    while ((ch = fgetc(file)) != EOF) {
-        string_append_char(&lexer->source_code, (char)ch);
+    /* Size the buffer once from the file length, so the whole file is pulled in with a single read */
+    file_size = 0;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        file_size = ftell(file);
+        if (file_size < 0)
+            file_size = 0;
+    }
+    rewind(file);
+
+    /* Offsets and lengths are unsigned ints and the EOF sentinel takes one more byte */
+    if ((unsigned long)file_size >= UINT_MAX) {
+        fclose(file);
+        lexer->source_code = string_create();
+        lexer_initialize_line_index(lexer);
+        error_handler_initialize(&lexer->error_handler, lexer->source_code, &lexer->line_index, lexer->file_path);
+        fprintf(stderr, "%sLexer Error:%s \"%s\" is too large.\n", RED_COLOR, RESET_COLOR, lexer->file_path);
+        return false;
     }
-    string_append_char(&lexer->source_code, EOF);
 
+    lexer->source_code = read_source(file, (size_t)file_size, &bytes_read);
     fclose(file);
 
+    /* The EOF sentinel and the terminator go in the two spare bytes, so the buffer is never copied */
+    lexer->source_code.data[bytes_read] = (char)EOF;
+    lexer->source_code.data[bytes_read + 1] = '\0';
+    lexer->source_code.length = (unsigned int)bytes_read + 1;
+
+    lexer_initialize_line_index(lexer);
+    error_handler_initialize(&lexer->error_handler, lexer->source_code, &lexer->line_index, lexer->file_path);
+
     lexer->index = 0;
     lexer->column = 0;
     lexer->current_char = string_char_at(lexer->source_code, lexer->index);
@@ -73,9 +353,12 @@ void lexer_initialize_from_string(Lexer *lexer, const char * file_path, String s
     string_append(&lexer->source_code, source_code);
 
     lexer->file_path = safe_strdup(file_path);
-    lexer->token_list = NULL;
+    token_array_initialize(&lexer->tokens);
+    lexer->macro_count = 0;
+    lexer->include_count = 0;
 
-    error_handler_initialize(&lexer->error_handler, lexer->source_code, lexer->file_path);
+    lexer_initialize_line_index(lexer);
+    error_handler_initialize(&lexer->error_handler, lexer->source_code, &lexer->line_index, lexer->file_path);
 
     lexer->index = 0;
     lexer->column = 0;
@@ -84,27 +367,26 @@ void lexer_initialize_from_string(Lexer *lexer, const char * file_path, String s
 }
 
 void lexer_free(Lexer *lexer) {
-    TokenNode *current = lexer->token_list;
-    TokenNode *temp;
-
-    while (current != NULL) {
-        string_free(current->token.string);
-        temp = current;
-        current = current->next;
-        free(temp);
-    }
+    /* Tokens only reference the source buffer, so the whole array goes in one release */
+    free(lexer->tokens.data);
+    token_array_initialize(&lexer->tokens);
+    lexer->macro_count = 0;
+    lexer->include_count = 0;
 
+    line_index_free(&lexer->line_index);
     string_free(lexer->source_code);
     free(lexer->file_path);
 }
 
 void lexer_print_token_list(Lexer * lexer){
-    const TokenNode *tokens = lexer->token_list;
+    const Token *token;
+    unsigned int i;
 
-    while (tokens != NULL) {
-        switch (tokens->token.type) {
+    for (i = 0; i < lexer->tokens.count; i++) {
+        token = &lexer->tokens.data[i];
+        switch (token->type) {
             case TOKEN_COMMENT:
-                printf("Comment: %s\n", tokens->token.string.data);
+                printf("Comment: %.*s\n", (int)token->length, token_text(*token, lexer->source_code));
                 break;
             case TOKEN_EOL:
                 printf("End of line: \\n\n");
@@ -125,28 +407,29 @@ void lexer_print_token_list(Lexer * lexer){
                 printf("Star: '*'\n");
                 break;
             case TOKEN_NUMBER:
-                printf("Number: %d\n", atoi(tokens->token.string.data));
+                printf("Number: %d%s\n", token->value, token->is_overflow ? " (overflow)" : "");
                 break;
             case TOKEN_STRING:
-                printf("String: %s\n", tokens->token.string.data);
+                printf("String: %.*s\n", (int)token->length, token_text(*token, lexer->source_code));
                 break;
             case TOKEN_DATA_INS:
             case TOKEN_STRING_INS:
             case TOKEN_ENTRY_INS:
             case TOKEN_EXTERN_INS:
-                printf("Non-operative instruction: %s\n", tokens->token.string.data);
+            case TOKEN_INCLUDE_INS:
+                printf("Non-operative instruction: %.*s\n", (int)token->length, token_text(*token, lexer->source_code));
                 break;
             case TOKEN_ERROR:
-                printf("Error token: %s\n", tokens->token.string.data);
+                printf("Error token: %.*s\n", (int)token->length, token_text(*token, lexer->source_code));
                 break;
             case TOKEN_REGISTER:
-                printf("Register: %s\n", tokens->token.string.data);
+                printf("Register: %.*s\n", (int)token->length, token_text(*token, lexer->source_code));
                 break;
             case TOKEN_MACR:
-                printf("Macro start token: %s\n", tokens->token.string.data);
+                printf("Macro start token: %.*s\n", (int)token->length, token_text(*token, lexer->source_code));
                 break;
             case TOKEN_ENDMACR:
-                printf("Macro end token: %s\n", tokens->token.string.data);
+                printf("Macro end token: %.*s\n", (int)token->length, token_text(*token, lexer->source_code));
                 break;
             case TOKEN_MOV:
             case TOKEN_CMP:
@@ -164,16 +447,15 @@ void lexer_print_token_list(Lexer * lexer){
             case TOKEN_JSR:
             case TOKEN_RTS:
             case TOKEN_STOP:
-                printf("Operative instruction: %s\n", tokens->token.string.data);
+                printf("Operative instruction: %.*s\n", (int)token->length, token_text(*token, lexer->source_code));
                 break;
             case TOKEN_IDENTIFIER:
-                printf("Identifier: %s\n", tokens->token.string.data);
+                printf("Identifier: %.*s\n", (int)token->length, token_text(*token, lexer->source_code));
                 break;
             default:
                 printf("Unknown token type\n");
                 break;
         }
-        tokens = tokens->next;
     }
 }
 
@@ -183,6 +465,7 @@ void lexer_advance_character(Lexer * lexer){
     if (lexer->current_char == '\n') {
         lexer->line_number++;
         lexer->column = 0;
+        line_index_add(&lexer->line_index, lexer->index + 1);
     } else {
         lexer->column++;
     }
@@ -194,17 +477,13 @@ void lexer_tokenize_comment(Lexer * lexer){
     Token token;
     token.type = TOKEN_COMMENT;
     token.index = lexer->index;
-    token.index_in_line = lexer->column;
-    token.line = lexer->line_number;
-    token.string = string_create();
 
-    while (lexer->current_char != '\0' && lexer->current_char != EOF && lexer->current_char != '\n') {
-        string_append_char(&token.string, lexer->current_char);
-        lexer_advance_character(lexer);
-    }
+    /* A comment can't hold a newline, so jump straight to the first one (or to the end of the input) */
+    lexer_skip_to(lexer, select_byte_scanner()(lexer->source_code.data + lexer->index, source_end(lexer),
+                                               '\n', (char)EOF, '\0', true));
+    token.length = lexer->index - token.index;
 
     /* Comments are typically ignored, so we don't add them to the token list */
-    string_free(token.string);
 }
 
 void lexer_tokenize_newline(Lexer * lexer){
@@ -212,10 +491,7 @@ void lexer_tokenize_newline(Lexer * lexer){
     Token token;
     token.type = TOKEN_EOL;
     token.index = lexer->index;
-    token.index_in_line = lexer->column;
-    token.line = lexer->line_number;
-    token.string = string_create_from_cstr("\n");
-
+    token.length = 1;
 
     lexer_advance_character(lexer);
     add_token(lexer, token);
@@ -224,30 +500,10 @@ void lexer_tokenize_newline(Lexer * lexer){
 void lexer_tokenize_separator(Lexer * lexer){
     Token token;
     token.index = lexer->index;
-    token.index_in_line = lexer->column;
-    token.line = lexer->line_number;
-    token.string = string_create();
+    token.length = 1;
 
+    token.type = separator_token_type(lexer->current_char);
 
-    switch (lexer->current_char) {
-        case ',':
-            token.type = TOKEN_COMMA;
-        break;
-        case ':':
-            token.type = TOKEN_COLON;
-        break;
-        case '#':
-            token.type = TOKEN_HASHTAG;
-        break;
-        case '*':
-            token.type = TOKEN_STAR;
-        break;
-        default:
-            token.type = TOKEN_ERROR;
-        break;
-    }
-
-    string_append_char(&token.string, lexer->current_char);
     lexer_advance_character(lexer);
     add_token(lexer, token);
 }
@@ -256,28 +512,18 @@ void lexer_tokenize_number(Lexer * lexer){
     Token token;
     token.type = TOKEN_NUMBER;
     token.index = lexer->index;
-    token.index_in_line = lexer->column;
-    token.line = lexer->line_number;
-    token.string = string_create();
 
 
     bool first_char = true;
     while (lexer->current_char != '\0' && lexer->current_char != EOF &&
            (isdigit(lexer->current_char) || (first_char && (lexer->current_char == '+' || lexer->current_char == '-')))) {
-        string_append_char(&token.string, lexer->current_char);
         lexer_advance_character(lexer);
         first_char = false;
            }
+    token.length = lexer->index - token.index;
 
-    if (string_length(token.string) == 1 && (string_char_at(token.string, 0) == '+' || string_char_at(token.string, 0) == '-')) {
-        CharError error;
-        error.character = string_char_at(token.string, 0);
-        error.fileIndex = token.index;
-        error.lineIndex = token.index_in_line;
-        error.lineNumber = token.line;
-        error.message = string_create_from_cstr("it seems that you have a ' - ' or ' + ' without any numerical chars after it");
-
-        error_handler_add_char_error(&lexer->error_handler, LEXER_ERROR_TYPE, error);
+    if (token.length == 1 && (lexer->source_code.data[token.index] == '+' || lexer->source_code.data[token.index] == '-')) {
+        report_char_error(&lexer->error_handler, lexer->source_code.data[token.index], token, LONE_SIGN_MESSAGE);
         token.type = TOKEN_ERROR;
     }
 
@@ -286,44 +532,29 @@ void lexer_tokenize_number(Lexer * lexer){
 
 void lexer_tokenize_string(Lexer * lexer){
     bool closer_string_found = false;
-    int index = lexer->index;
-    int line = lexer->line_number;
-    int index_in_line = lexer->line_number;
-    int i;
-
-    CharError error;
+    const char *body_end;
 
     Token token;
     token.type = TOKEN_STRING;
-    token.index = index;
-    token.index_in_line = index_in_line;
-    token.line = line;
-    token.string = string_create();
+    token.index = lexer->index;
 
 
-    for (i = 0; !(chars_are_equal(lexer->current_char, EOF) || chars_are_equal(lexer->current_char, '\0')); i++){
-        if (i != 0 && lexer->current_char == '\"') {
+    if (!(chars_are_equal(lexer->current_char, EOF) || chars_are_equal(lexer->current_char, '\0'))) {
+        /* Step over the opening char, then jump over the whole body (it may run over several lines) */
+        body_end = select_byte_scanner()(lexer->source_code.data + lexer->index + 1, source_end(lexer),
+                                         '\"', (char)EOF, '\0', true);
+        if (*body_end == '\"') {
             closer_string_found = true;
+            body_end++;
         }
-
-        string_append_char(&token.string, lexer->current_char);
-        lexer_advance_character(lexer);
-
-        if (closer_string_found == true)
-            break;
+        lexer_skip_to(lexer, body_end);
     }
+    token.length = lexer->index - token.index;
 
     if (closer_string_found == false){
         /* there isn't a known non operative instruction that match the one that we know, so we raise an error */
         token.type = TOKEN_ERROR;
-
-        error.character = '\"';
-        error.fileIndex = index;
-        error.lineIndex = index_in_line;
-        error.lineNumber = line;
-        error.message = string_create_from_cstr("There is no string after \"");
-
-        error_handler_add_char_error(&lexer->error_handler, LEXER_ERROR_TYPE, error);
+        report_char_error(&lexer->error_handler, '\"', token, UNCLOSED_STRING_MESSAGE);
     }
 
     add_token(lexer, token);
@@ -331,34 +562,18 @@ void lexer_tokenize_string(Lexer * lexer){
 
 void lexer_tokenize_non_op_instruction(Lexer * lexer){
     Token token;
-    TokenError error;
     token.index = lexer->index;
-    token.index_in_line = lexer->column;
-    token.line = lexer->line_number;
-    token.string = string_create();
-    
 
 
     while (lexer->current_char != '\0' && lexer->current_char != EOF &&
-           (token.string.length == 0 || is_valid_identifier_start(lexer->current_char))) {
-        string_append_char(&token.string, lexer->current_char);
+           (lexer->index == token.index || is_valid_identifier_start(lexer->current_char))) {
         lexer_advance_character(lexer);
            }
+    token.length = lexer->index - token.index;
 
-    if (string_equals_cstr(token.string, ".data"))
-        token.type = TOKEN_DATA_INS;
-    else if (string_equals_cstr(token.string, ".string"))
-        token.type = TOKEN_STRING_INS;
-    else if (string_equals_cstr(token.string, ".entry"))
-        token.type = TOKEN_ENTRY_INS;
-    else if (string_equals_cstr(token.string, ".extern"))
-        token.type = TOKEN_EXTERN_INS;
-    else {
-        token.type = TOKEN_ERROR;
-        error.token = token;
-        error.message = string_create_from_cstr("Unknown non-operative instruction");
-
-        error_handler_add_token_error(&lexer->error_handler, LEXER_ERROR_TYPE, error);
+    token.type = classify_reserved_word(token_text(token, lexer->source_code), token.length, TOKEN_ERROR);
+    if (token.type == TOKEN_ERROR) {
+        report_token_error(&lexer->error_handler, token, UNKNOWN_DIRECTIVE_MESSAGE);
     }
 
     add_token(lexer, token);
@@ -368,9 +583,6 @@ void lexer_tokenize_non_op_instruction(Lexer * lexer){
 void lexer_tokenize_identifier(Lexer * lexer){
     Token token;
     token.index = lexer->index;
-    token.index_in_line = lexer->column;
-    token.line = lexer->line_number;
-    token.string = string_create();
 
 
     bool is_macro = false;
@@ -380,54 +592,12 @@ void lexer_tokenize_identifier(Lexer * lexer){
 
     while (lexer->current_char != '\0' && lexer->current_char != EOF &&
            (is_macro ? is_valid_macro_char(lexer->current_char) : is_valid_identifier_char(lexer->current_char))) {
-        string_append_char(&token.string, lexer->current_char);
         lexer_advance_character(lexer);
            }
+    token.length = lexer->index - token.index;
 
     /* Classify identifiers */
-    if (string_equals_cstr(token.string, "r0") || string_equals_cstr(token.string, "r1") ||
-        string_equals_cstr(token.string, "r2") || string_equals_cstr(token.string, "r3") ||
-        string_equals_cstr(token.string, "r4") || string_equals_cstr(token.string, "r5") ||
-        string_equals_cstr(token.string, "r6") || string_equals_cstr(token.string, "r7"))
-        token.type = TOKEN_REGISTER;
-    else if (string_equals_cstr(token.string, "macr"))
-        token.type = TOKEN_MACR;
-    else if (string_equals_cstr(token.string, "endmacr"))
-        token.type = TOKEN_ENDMACR;
-    else if (string_equals_cstr(token.string, "mov"))
-        token.type = TOKEN_MOV;
-    else if (string_equals_cstr(token.string, "cmp"))
-        token.type = TOKEN_CMP;
-    else if (string_equals_cstr(token.string, "add"))
-        token.type = TOKEN_ADD;
-    else if (string_equals_cstr(token.string, "sub"))
-        token.type = TOKEN_SUB;
-    else if (string_equals_cstr(token.string, "lea"))
-        token.type = TOKEN_LEA;
-    else if (string_equals_cstr(token.string, "clr"))
-        token.type = TOKEN_CLR;
-    else if (string_equals_cstr(token.string, "not"))
-        token.type = TOKEN_NOT;
-    else if (string_equals_cstr(token.string, "inc"))
-        token.type = TOKEN_INC;
-    else if (string_equals_cstr(token.string, "dec"))
-        token.type = TOKEN_DEC;
-    else if (string_equals_cstr(token.string, "jmp"))
-        token.type = TOKEN_JMP;
-    else if (string_equals_cstr(token.string, "bne"))
-        token.type = TOKEN_BNE;
-    else if (string_equals_cstr(token.string, "red"))
-        token.type = TOKEN_RED;
-    else if (string_equals_cstr(token.string, "prn"))
-        token.type = TOKEN_PRN;
-    else if (string_equals_cstr(token.string, "jsr"))
-        token.type = TOKEN_JSR;
-    else if (string_equals_cstr(token.string, "rts"))
-        token.type = TOKEN_RTS;
-    else if (string_equals_cstr(token.string, "stop"))
-        token.type = TOKEN_STOP;
-    else
-        token.type = TOKEN_IDENTIFIER;
+    token.type = classify_reserved_word(token_text(token, lexer->source_code), token.length, TOKEN_IDENTIFIER);
 
     add_token(lexer, token);
 }
@@ -437,49 +607,455 @@ void lexer_tokenize_eof(Lexer *lexer){
     Token token;
     token.type = TOKEN_EOFT;
     token.index = lexer->index;
-    token.index_in_line = lexer->column;
-    token.line = lexer->line_number;
-    token.string = string_create_from_cstr("\0");
+    token.length = 0;
 
     lexer_advance_character(lexer);
     add_token(lexer, token);
 }
 
-/*For each character, it checks its type and calls the appropriate function to handle it */
 void lexer_analyze(Lexer * lexer){
-    while (!chars_are_equal(lexer->current_char, '\0')) {
-        if (is_whitespace(lexer->current_char)) {
-            lexer_advance_character(lexer); /* we simply move over whitespaces */
-        } else if (chars_are_equal(lexer->current_char, ';')) {
-            lexer_tokenize_comment(lexer);
-        } else if (chars_are_equal(lexer->current_char, '\n')) {
-            lexer_tokenize_newline(lexer);
-        } else if (chars_are_equal(lexer->current_char, EOF)) {
-            lexer_tokenize_eof(lexer);
-        } else if (char_exists_in_string(lexer->current_char, ",:#*")) {
-            lexer_tokenize_separator(lexer);
-        } else if (is_digit(lexer->current_char) || char_exists_in_string(lexer->current_char, "+-")) {
-            lexer_tokenize_number(lexer);
-        } else if (chars_are_equal(lexer->current_char, '\"')) {
-            lexer_tokenize_string(lexer);
-        } else if (chars_are_equal(lexer->current_char, '.')) {
-            lexer_tokenize_non_op_instruction(lexer);
-        } else if (is_valid_identifier_start(lexer->current_char) || lexer->current_char == '_' ){
-            lexer_tokenize_identifier(lexer);
-        } else {
-            CharError error;
-
-            error.character = lexer->current_char;
-            error.fileIndex = lexer->index;
-            error.lineIndex = lexer->column;
-            error.lineNumber = lexer->line_number;
-            error.message = string_create_from_cstr("unknown char (in the current context)");
-
-            error_handler_add_char_error(&lexer->error_handler, LEXER_ERROR_TYPE, error);
-
-            lexer_advance_character(lexer);
+#ifdef LEXER_THREADS
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned long chunk_count = lexer->source_code.length / MIN_CHUNK_SIZE;
+
+    if (processors > 0 && chunk_count > (unsigned long)processors)
+        chunk_count = processors;
+    if (chunk_count > MAX_LEXER_THREADS)
+        chunk_count = MAX_LEXER_THREADS;
+    if (chunk_count > 1 && lexer->index == 0) {
+        lexer_analyze_chunks(lexer, (unsigned int)chunk_count);
+        return;
+    }
+#endif
+    scan_range(lexer, source_end(lexer));
+    terminate_token_stream(lexer);
+}
+
+void lexer_analyze_chunks(Lexer *lexer, unsigned int chunk_count){
+    LexerChunk *chunks;
+    unsigned int i;
+
+    if (chunk_count < 1)
+        chunk_count = 1;
+    if (chunk_count > MAX_LEXER_THREADS)
+        chunk_count = MAX_LEXER_THREADS;
+    chunks = safe_malloc(chunk_count * sizeof(LexerChunk));
+    chunk_count = cut_chunks(lexer, chunks, chunk_count);
+
+    /* Every chunk but the first is lexed on its own thread, the first one is lexed right into the lexer meanwhile */
+#ifdef LEXER_THREADS
+    for (i = 1; i < chunk_count; i++) {
+        chunks[i].threaded = pthread_create(&chunks[i].thread, NULL, lex_chunk, &chunks[i]) == 0;
+    }
+#endif
+    scan_range(lexer, lexer->source_code.data + chunks[0].end);
+
+    for (i = 1; i < chunk_count; i++) {
+#ifdef LEXER_THREADS
+        if (chunks[i].threaded)
+            pthread_join(chunks[i].thread, NULL);
+        else
+#endif
+            lex_chunk(&chunks[i]);
+        join_chunk(lexer, &chunks[i]);
+    }
+
+    free(chunks);
+    terminate_token_stream(lexer);
+}
+
+/* Scans the source with the DFA until a token would start at or past stop (the token before may run past it).
+ * The cursor is a raw pointer and every char costs two table lookups
+ * (blank runs, comments and string bodies are skipped with the vector scanner instead) */
+static void scan_range(Lexer *lexer, const char *stop){
+    const char *base = lexer->source_code.data;
+    const char *cursor = base + lexer->index;
+    const char *line_start = cursor - lexer->column;
+    const char *end = source_end(lexer);
+    const char *newline;
+    ByteScanner scan_bytes = select_byte_scanner();
+    unsigned int line = lexer->line_number;
+    unsigned char state;
+    unsigned char next;
+    Token token;
+
+    while (cursor < stop && char_classes[(unsigned char)*cursor] != CLASS_END) {
+        token.index = cursor - base;
+
+        state = scan_transitions[STATE_START][char_classes[(unsigned char)*cursor]];
+        cursor++;
+        if (state == STATE_START) {
+            /* we simply move over whitespaces */
+            cursor = scan_bytes(cursor, end, ' ', '\t', '\r', false);
+            continue;
+        }
+
+        /* Comment and string bodies are skipped in bulk, the DFA then only sees the char that ends them */
+        if (state == STATE_COMMENT)
+            cursor = scan_bytes(cursor, end, '\n', (char)EOF, '\0', true);
+        else if (state == STATE_STRING)
+            cursor = scan_bytes(cursor, end, '\"', (char)EOF, '\0', true);
+
+        while ((next = scan_transitions[state][char_classes[(unsigned char)*cursor]]) != STATE_DONE) {
+            state = next;
+            cursor++;
+        }
+        token.length = (cursor - base) - token.index;
+
+        switch (state) {
+            case STATE_IDENTIFIER:
+            case STATE_MACRO_IDENTIFIER:
+                token.type = classify_reserved_word(base + token.index, token.length, TOKEN_IDENTIFIER);
+                add_token(lexer, token);
+                break;
+            case STATE_DIRECTIVE:
+                token.type = classify_reserved_word(base + token.index, token.length, TOKEN_ERROR);
+                if (token.type == TOKEN_ERROR)
+                    report_token_error(&lexer->error_handler, token, UNKNOWN_DIRECTIVE_MESSAGE);
+                add_token(lexer, token);
+                break;
+            case STATE_NUMBER:
+                token.type = TOKEN_NUMBER;
+                add_token(lexer, token);
+                break;
+            case STATE_SIGN:
+                token.type = TOKEN_ERROR;
+                report_char_error(&lexer->error_handler, base[token.index], token, LONE_SIGN_MESSAGE);
+                add_token(lexer, token);
+                break;
+            case STATE_STRING:
+            case STATE_STRING_CLOSED:
+                if (state == STATE_STRING_CLOSED) {
+                    token.type = TOKEN_STRING;
+                } else {
+                    token.type = TOKEN_ERROR;
+                    report_char_error(&lexer->error_handler, '\"', token, UNCLOSED_STRING_MESSAGE);
+                }
+                add_token(lexer, token);
+
+                /* Strings are the only tokens that may span lines */
+                newline = memchr(base + token.index, '\n', token.length);
+                while (newline != NULL) {
+                    line++;
+                    line_start = newline + 1;
+                    line_index_add(&lexer->line_index, line_start - base);
+                    newline = memchr(line_start, '\n', cursor - line_start);
+                }
+                break;
+            case STATE_SEPARATOR:
+                token.type = separator_token_type(base[token.index]);
+                add_token(lexer, token);
+                break;
+            case STATE_NEWLINE:
+                token.type = TOKEN_EOL;
+                add_token(lexer, token);
+                line++;
+                line_start = cursor;
+                line_index_add(&lexer->line_index, line_start - base);
+                break;
+            case STATE_EOF:
+                token.type = TOKEN_EOFT;
+                token.length = 0;
+                add_token(lexer, token);
+                break;
+            case STATE_INVALID:
+                report_char_error(&lexer->error_handler, base[token.index], token, UNKNOWN_CHAR_MESSAGE);
+                break;
+            default:
+                break; /* comments are ignored */
+        }
+    }
+
+    lexer->index = cursor - base;
+    lexer->column = cursor - line_start;
+    lexer->line_number = line;
+    lexer->current_char = *cursor;
+}
+
+/* Consumers rely on the token stream always being terminated by an EOF token */
+static void terminate_token_stream(Lexer *lexer){
+    if (lexer->tokens.count == 0 || lexer->tokens.data[lexer->tokens.count - 1].type != TOKEN_EOFT) {
+        lexer_tokenize_eof(lexer);
+    }
+}
+
+/* Cuts the source in up to chunk_count chunks of about the same size, each one starting right after a newline.
+ * Returns the number of chunks (a source with few lines gets fewer), chunks[0] is the lexer itself and is not set up. */
+static unsigned int cut_chunks(Lexer *lexer, LexerChunk *chunks, unsigned int chunk_count){
+    const char *base = lexer->source_code.data;
+    unsigned int length = lexer->source_code.length;
+    unsigned int count = 1;
+    unsigned int start = 0;
+    unsigned int target;
+    const char *newline;
+    Lexer *chunk;
+    unsigned int i;
+
+    for (i = 1; i < chunk_count; i++) {
+        target = (unsigned int)((unsigned long)length * i / chunk_count);
+        if (target < start)
+            target = start;
+        newline = memchr(base + target, '\n', length - target);
+        if (newline == NULL || (unsigned int)(newline + 1 - base) >= length)
+            break;
+        start = newline + 1 - base;
+
+        chunks[count].start = start;
+        chunks[count - 1].end = start;
+        count++;
+    }
+    chunks[count - 1].end = length;
+
+    for (i = 1; i < count; i++) {
+        chunk = &chunks[i].lexer;
+        chunk->source_code = lexer->source_code;
+        chunk->file_path = lexer->file_path;
+        chunk->index = chunks[i].start;
+        chunk->column = 0;
+        chunk->current_char = base[chunk->index];
+        chunk->line_number = 1; /* Counted from the chunk's first line until it is joined */
+        token_array_initialize(&chunk->tokens);
+        chunk->macro_count = 0;
+        chunk->include_count = 0;
+
+        line_index_initialize(&chunk->line_index);
+        line_index_add(&chunk->line_index, chunks[i].start);
+        error_handler_initialize(&chunk->error_handler, chunk->source_code, &chunk->line_index, chunk->file_path);
+    }
+
+    return count;
+}
+
+/* Thread entry, lexes one chunk (the signature is the one pthread_create takes) */
+static void *lex_chunk(void *chunk){
+    LexerChunk *lexer_chunk = chunk;
+
+    scan_range(&lexer_chunk->lexer, lexer_chunk->lexer.source_code.data + lexer_chunk->end);
+    return NULL;
+}
+
+/*
+ * Appends a lexed chunk to the lexer, which has lexed everything before it.
+ * A chunk is lexed as if a token starts on its first char, that only holds when the lexer stopped right there.
+ * When a string of the chunk before ran into it, the chunk's own tokens are thrown away and it is lexed again
+ * from where the string ended, and when the lexer stopped short (it met the end of input) the chunk is dropped.
+ */
+static void join_chunk(Lexer *lexer, LexerChunk *chunk){
+    Lexer *chunk_lexer = &chunk->lexer;
+    unsigned int i;
+
+    if (lexer->index == chunk->start) {
+        append_tokens(&lexer->tokens, chunk_lexer->tokens.data, chunk_lexer->tokens.count);
+        lexer->macro_count += chunk_lexer->macro_count;
+        lexer->include_count += chunk_lexer->include_count;
+
+        for (i = 0; i < chunk_lexer->line_index.count; i++) {
+            line_index_add(&lexer->line_index, chunk_lexer->line_index.starts[i]);
         }
+        /* The chunk's char errors were placed by its own lines, they are placed again by the whole index */
+        error_handler_take_errors(&lexer->error_handler, &chunk_lexer->error_handler);
+
+        lexer->index = chunk_lexer->index;
+        lexer->column = chunk_lexer->column;
+        lexer->line_number += chunk_lexer->line_number - 1;
+        lexer->current_char = chunk_lexer->current_char;
+    } else if (lexer->index > chunk->start) {
+        scan_range(lexer, lexer->source_code.data + chunk->end);
+    }
+
+    free(chunk_lexer->tokens.data);
+    line_index_free(&chunk_lexer->line_index);
+    error_handler_free(&chunk_lexer->error_handler);
+}
+
+const char *token_text(Token token, String source){
+    return source.data + token.index;
+}
+
+String token_to_string(Token token, String source){
+    String str = string_create();
+    string_append_chars(&str, token_text(token, source), token.length);
+    return str;
+}
+
+bool token_equals(Token first, Token second, String source){
+    return first.length == second.length &&
+           memcmp(token_text(first, source), token_text(second, source), first.length) == 0;
+}
+
+bool lexer_stream_open(LexerStream *stream, char *file_path, unsigned long capacity){
+    char *full_path;
+
+    full_path = safe_malloc(strlen(file_path) + 4); /* +4 for ".as" and null terminator*/
+    sprintf(full_path, "%s.as", file_path);
+    stream->file_path = full_path;
+
+    /* Round the capacity up to a power of two so a position maps to its slot with a mask */
+    stream->capacity = STREAM_MIN_CAPACITY;
+    while (stream->capacity < capacity)
+        stream->capacity *= 2;
+
+    stream->ring = safe_malloc(stream->capacity);
+    stream->text = safe_malloc(stream->capacity);
+    stream->head = 0;
+    stream->tail = 0;
+    stream->cursor = 0;
+    stream->line_start = 0;
+    stream->token_start = 0;
+    stream->line_number = 1;
+    stream->end_of_file = false;
+    stream->finished = false;
+
+    /* The source is never held as a whole (nor its line starts), so errors are reported without the source line */
+    line_index_initialize(&stream->no_lines);
+    error_handler_initialize(&stream->error_handler, string_create(), &stream->no_lines, stream->file_path);
+
+    stream->file = fopen(stream->file_path, "r");
+    if (stream->file == NULL) {
+        fprintf(stderr, "%sLexer Error:%s Couldn't open \"%s\".\n", RED_COLOR, RESET_COLOR, stream->file_path);
+        stream->end_of_file = true;
+        stream->finished = true;
+        return false;
     }
+
+    return true;
+}
+
+/* Runs the same DFA as lexer_analyze, one char at a time through the ring (a token may wrap around its end) */
+bool lexer_stream_next(LexerStream *stream, Token *token){
+    unsigned char state;
+    unsigned char next;
+    char first_char;
+    char ch;
+    bool overflowed;
+
+    while (!stream->finished) {
+        /* The previous token is handed over, its bytes may be overwritten from now on */
+        stream->head = stream->cursor;
+        stream->token_start = stream->cursor;
+
+        token->index = (unsigned int)stream->cursor;
+        stream->token_line = stream->line_number;
+        stream->token_column = (unsigned int)(stream->cursor - stream->line_start);
+
+        first_char = stream_char_at(stream, stream->cursor);
+        state = scan_transitions[STATE_START][char_classes[(unsigned char)first_char]];
+        stream->cursor++;
+        if (state == STATE_START)
+            continue; /* we simply move over whitespaces */
+
+        while ((next = scan_transitions[state][char_classes[(unsigned char)(ch = stream_char_at(stream, stream->cursor))]]) != STATE_DONE) {
+            /* Strings are the only tokens that may span lines */
+            if (ch == '\n') {
+                stream->line_number++;
+                stream->line_start = stream->cursor + 1;
+            }
+            /* Comment text is never handed out, so it's released as soon as it is read */
+            if (state == STATE_COMMENT)
+                stream->head = stream->cursor;
+            state = next;
+            stream->cursor++;
+        }
+        token->length = (unsigned int)(stream->cursor - stream->token_start);
+        token->value = 0;
+        token->is_overflow = 0;
+        token->expansion = 0;
+
+        /* Token offsets are unsigned ints, past UINT_MAX they would wrap and break offset comparisons, so the file ends there */
+        if (stream->cursor > UINT_MAX) {
+            report_stream_error(stream, first_char, SOURCE_TOO_LARGE_MESSAGE);
+            token->type = TOKEN_EOFT;
+            token->index = UINT_MAX;
+            token->length = 0;
+            stream->finished = true;
+            return true;
+        }
+
+        /* A token that didn't fit lost its first bytes to the rest of it, only its position is kept */
+        overflowed = stream->head > stream->token_start && state != STATE_COMMENT;
+        if (overflowed) {
+            token->type = TOKEN_ERROR;
+            token->length = 0;
+            report_stream_error(stream, first_char, TOKEN_TOO_LONG_MESSAGE);
+            stream->token_start = stream->cursor;
+            return true;
+        }
+
+        switch (state) {
+            case STATE_IDENTIFIER:
+            case STATE_MACRO_IDENTIFIER:
+                token->type = classify_reserved_word(lexer_stream_token_text(stream, *token), token->length, TOKEN_IDENTIFIER);
+                set_token_value(token, lexer_stream_token_text(stream, *token));
+                return true;
+            case STATE_DIRECTIVE:
+                token->type = classify_reserved_word(lexer_stream_token_text(stream, *token), token->length, TOKEN_ERROR);
+                if (token->type == TOKEN_ERROR)
+                    report_stream_error(stream, first_char, UNKNOWN_DIRECTIVE_MESSAGE);
+                return true;
+            case STATE_NUMBER:
+                token->type = TOKEN_NUMBER;
+                set_token_value(token, lexer_stream_token_text(stream, *token));
+                return true;
+            case STATE_SIGN:
+                token->type = TOKEN_ERROR;
+                report_stream_error(stream, first_char, LONE_SIGN_MESSAGE);
+                return true;
+            case STATE_STRING:
+                token->type = TOKEN_ERROR;
+                report_stream_error(stream, '\"', UNCLOSED_STRING_MESSAGE);
+                return true;
+            case STATE_STRING_CLOSED:
+                token->type = TOKEN_STRING;
+                return true;
+            case STATE_SEPARATOR:
+                token->type = separator_token_type(first_char);
+                return true;
+            case STATE_NEWLINE:
+                token->type = TOKEN_EOL;
+                stream->line_number++;
+                stream->line_start = stream->cursor;
+                return true;
+            case STATE_EOF:
+            case STATE_DONE:
+                /* Consumers rely on the token stream always being terminated by an EOF token */
+                token->type = TOKEN_EOFT;
+                token->length = 0;
+                stream->finished = true;
+                return true;
+            case STATE_INVALID:
+                report_stream_error(stream, first_char, UNKNOWN_CHAR_MESSAGE);
+                break;
+            default:
+                break; /* comments are ignored */
+        }
+    }
+
+    return false;
+}
+
+const char *lexer_stream_token_text(LexerStream *stream, Token token){
+    unsigned long mask = stream->capacity - 1;
+    unsigned long slot = stream->token_start & mask;
+    unsigned long first_part;
+
+    if (slot + token.length <= stream->capacity)
+        return stream->ring + slot;
+
+    /* The token wraps around the end of the ring, glue its two parts together */
+    first_part = stream->capacity - slot;
+    memcpy(stream->text, stream->ring + slot, first_part);
+    memcpy(stream->text + first_part, stream->ring, token.length - first_part);
+    return stream->text;
+}
+
+void lexer_stream_close(LexerStream *stream){
+    if (stream->file != NULL)
+        fclose(stream->file);
+    free(stream->ring);
+    free(stream->text);
+    error_handler_free(&stream->error_handler);
+    string_free(stream->error_handler.string);
+    free(stream->file_path);
 }
 
 int lexer_is_end_of_input(Lexer *lexer) {
@@ -510,22 +1086,364 @@ static char* safe_strdup(const char* str) {
     return new_str;
 }
 
+/**
+ * Read a whole source file into a single buffer.
+ * The buffer always keeps two spare bytes past the data for the EOF sentinel and the null terminator.
+ *
+ * @param file The opened source file, positioned at its start.
+ * @param expected_size The file size as reported by the file system (used to size the buffer up front).
+ * @param bytes_read Output, the number of source bytes placed in the buffer.
+ * @return A String owning the buffer (its length is left for the caller to set).
+ */
+static String read_source(FILE *file, size_t expected_size, size_t *bytes_read){
+    String source;
+    int ch;
+
+    source.capacity = (unsigned int)expected_size + 2;
+    source.length = 0;
+    source.data = safe_malloc(source.capacity);
+
+    *bytes_read = fread(source.data, 1, expected_size, file);
+
+    /* The file may have grown since it was measured (or it is not seekable), take whatever is left */
+    while ((ch = fgetc(file)) != EOF) {
+        if (*bytes_read + 2 >= source.capacity) {
+            source.capacity *= 2;
+            source.data = safe_realloc(source.data, source.capacity);
+        }
+        source.data[(*bytes_read)++] = (char)ch;
+    }
+
+    *bytes_read = drop_nul_bytes(source.data, *bytes_read);
+
+    return source;
+}
+
+/* Null bytes were never part of the source text, drop them like string_append_char does. Returns the new count */
+static size_t drop_nul_bytes(char *data, size_t count){
+    char *nul = memchr(data, '\0', count);
+    char *write;
+    char *read;
+
+    if (nul == NULL)
+        return count;
+
+    write = nul;
+    for (read = nul; read < data + count; read++) {
+        if (*read != '\0')
+            *write++ = *read;
+    }
+    return write - data;
+}
+
+static void token_array_initialize(TokenArray *array){
+    array->data = NULL;
+    array->count = 0;
+    array->capacity = 0;
+}
+
+static void append_tokens(TokenArray *array, const Token *tokens, unsigned int count){
+    unsigned int needed = array->count + count;
+
+    if (count == 0)
+        return;
+
+    /* Grow geometrically so appending stays amortized O(1) */
+    if (needed > array->capacity) {
+        if (array->capacity == 0)
+            array->capacity = INITIAL_TOKEN_CAPACITY;
+        while (array->capacity < needed) {
+            array->capacity *= 2;
+        }
+        array->data = safe_realloc(array->data, array->capacity * sizeof(Token));
+    }
+
+    memcpy(array->data + array->count, tokens, count * sizeof(Token));
+    array->count = needed;
+}
+
 static void add_token(Lexer * lexer, Token token){
-    TokenNode * new_node = safe_malloc(sizeof(TokenNode));
-    new_node->token = token;
-    new_node->next = NULL;
-
-    if (lexer->token_list == NULL){
-        lexer->token_list = new_node;
-    }else{
-        TokenNode * last = lexer->token_list;
-        while (last->next != NULL){
-            last = last->next;
+    TokenArray *array = &lexer->tokens;
+
+    token.expansion = 0; /* Lexed where it was written */
+    set_token_value(&token, lexer->source_code.data + token.index);
+    if (token.type == TOKEN_MACR)
+        lexer->macro_count++;
+    else if (token.type == TOKEN_INCLUDE_INS)
+        lexer->include_count++;
+
+    /* Grow geometrically so appending stays amortized O(1) */
+    if (array->count == array->capacity) {
+        array->capacity = (array->capacity == 0) ? INITIAL_TOKEN_CAPACITY : array->capacity * 2;
+        array->data = safe_realloc(array->data, array->capacity * sizeof(Token));
+    }
+
+    array->data[array->count++] = token;
+}
+
+/**
+ * Classify a word against the reserved word table.
+ *
+ * @param text The characters of the word.
+ * @param length The number of characters in the word.
+ * @param fallback The type to return when the word is not reserved.
+ * @return The reserved word's token type, or fallback if there is no match.
+ */
+static TokenType classify_reserved_word(const char *text, unsigned int length, TokenType fallback){
+    const ReservedWord *slot;
+    unsigned int hash;
+
+    /* Every reserved word has at least two characters */
+    if (length < 2)
+        return fallback;
+
+    hash = ((unsigned char)text[0] * 7u + (unsigned char)text[1] * 2u +
+            (unsigned char)text[length - 1] * 21u + length) & (RESERVED_WORD_SLOTS - 1);
+    slot = &reserved_words[hash];
+
+    if (slot->length == length && memcmp(slot->text, text, length) == 0)
+        return slot->type;
+
+    return fallback;
+}
+
+/**
+ * Computes the payload of a token, once, so no later stage parses its text again.
+ *
+ * @param token The token, its type and length are set. Its value and overflow flag are set here:
+ *              a number's value (saturated to the int range), a register's number, or 0 for any other token.
+ * @param text The characters of the token.
+ */
+static void set_token_value(Token *token, const char *text){
+    unsigned int i = 0;
+    unsigned long magnitude = 0;
+    unsigned long limit; /* The largest magnitude the literal's sign allows */
+    unsigned int digit;
+    bool negative = false;
+
+    token->value = 0;
+    token->is_overflow = 0;
+
+    if (token->type == TOKEN_REGISTER) {
+        token->value = text[1] - '0';
+        return;
+    }
+    if (token->type != TOKEN_NUMBER)
+        return;
+
+    if (text[0] == '+' || text[0] == '-') {
+        negative = text[0] == '-';
+        i++;
+    }
+    limit = negative ? (unsigned long)INT_MAX + 1 : (unsigned long)INT_MAX;
+    for (; i < token->length; i++) {
+        digit = (unsigned int)(text[i] - '0');
+        if (magnitude > (limit - digit) / 10) {
+            magnitude = limit; /* Saturate, the flag tells the later stages it is not the literal's value */
+            token->is_overflow = 1;
+            break;
         }
-        last->next = new_node;
+        magnitude = magnitude * 10 + digit;
     }
+
+    if (!negative)
+        token->value = (int)magnitude;
+    else if (magnitude > (unsigned long)INT_MAX)
+        token->value = INT_MIN;
+    else
+        token->value = -(int)magnitude;
 }
 
+static TokenType separator_token_type(char ch){
+    switch (ch) {
+        case ',':
+            return TOKEN_COMMA;
+        case ':':
+            return TOKEN_COLON;
+        case '#':
+            return TOKEN_HASHTAG;
+        case '*':
+            return TOKEN_STAR;
+        default:
+            return TOKEN_ERROR;
+    }
+}
+
+/* Reports an error on a single char, placed at the start of the given token (its lines were all recorded by now) */
+static void report_char_error(ErrorHandler *handler, char ch, Token token, const char *message){
+    CharError error;
+
+    error.character = ch;
+    error.fileIndex = token.index;
+    error.lineIndex = line_index_find_column(*handler->line_index, token.index);
+    error.lineNumber = line_index_find_line(*handler->line_index, token.index);
+    error.message = string_create_from_cstr(message);
+
+    error_handler_add_char_error(handler, LEXER_ERROR_TYPE, error);
+}
+
+/* Reports an error at the start of the stream's last token, a stream keeps no line index so its own position is used */
+static void report_stream_error(LexerStream *stream, char ch, const char *message){
+    CharError error;
+
+    error.character = ch;
+    error.fileIndex = (unsigned int)stream->token_start;
+    error.lineIndex = stream->token_column;
+    error.lineNumber = stream->token_line;
+    error.message = string_create_from_cstr(message);
+
+    error_handler_add_char_error(&stream->error_handler, LEXER_ERROR_TYPE, error);
+}
+
+static void report_token_error(ErrorHandler *handler, Token token, const char *message){
+    TokenError error;
+
+    error.token = token;
+    error.token.value = 0; /* Reported before add_token gives it a payload, and an error token has none */
+    error.token.is_overflow = 0;
+    error.token.expansion = 0;
+    error.message = string_create_from_cstr(message);
+
+    error_handler_add_token_error(handler, LEXER_ERROR_TYPE, error);
+}
+
+/* One past the null terminator of the source, the furthest a scanner may read */
+static const char *source_end(Lexer *lexer){
+    return lexer->source_code.data + lexer->source_code.length + 1;
+}
+
+/* Every source starts with line 1 at offset 0 */
+static void lexer_initialize_line_index(Lexer *lexer){
+    line_index_initialize(&lexer->line_index);
+    line_index_add(&lexer->line_index, 0);
+}
+
+/* Moves the lexer forward to target in one step, keeping the line and column as lexer_advance_character would */
+static void lexer_skip_to(Lexer *lexer, const char *target){
+    const char *cursor = lexer->source_code.data + lexer->index;
+    const char *newline;
+
+    lexer->column += target - cursor;
+    while ((newline = memchr(cursor, '\n', target - cursor)) != NULL) {
+        lexer->line_number++;
+        lexer->column = target - (newline + 1);
+        cursor = newline + 1;
+        line_index_add(&lexer->line_index, cursor - lexer->source_code.data);
+    }
+
+    lexer->index = target - lexer->source_code.data;
+    lexer->current_char = string_char_at(lexer->source_code, lexer->index);
+}
+
+/**
+ * Reads the next run of the file into the free part of the ring.
+ * Once the ring is full the oldest half of the current token is dropped to make room (see lexer_stream_next).
+ *
+ * @param stream The stream to read into.
+ * @return true if new bytes were added, false at the end of the file.
+ */
+static bool stream_fill(LexerStream *stream){
+    unsigned long slot;
+    size_t room;
+    size_t read;
+    size_t kept;
+
+    if (stream->tail - stream->head == stream->capacity)
+        stream->head += stream->capacity / 2;
+
+    /* Read up to the end of the ring at most, the next fill continues from its start */
+    slot = stream->tail & (stream->capacity - 1);
+    room = stream->capacity - (stream->tail - stream->head);
+    if (room > stream->capacity - slot)
+        room = stream->capacity - slot;
+
+    do {
+        read = fread(stream->ring + slot, 1, room, stream->file);
+        kept = drop_nul_bytes(stream->ring + slot, read);
+    } while (read > 0 && kept == 0);
+
+    if (read == 0) {
+        stream->end_of_file = true;
+        return false;
+    }
+
+    stream->tail += kept;
+    return true;
+}
+
+/* The char at an absolute file offset, the EOF sentinel right after the last byte and '\0' past it */
+static char stream_char_at(LexerStream *stream, unsigned long offset){
+    while (offset >= stream->tail && !stream->end_of_file)
+        stream_fill(stream);
+
+    if (offset < stream->tail)
+        return stream->ring[offset & (stream->capacity - 1)];
+    return offset == stream->tail ? (char)EOF : '\0';
+}
+
+static const char *scan_bytes_scalar(const char *cursor, const char *end, char first, char second, char third, bool stop_on_match){
+    while (cursor < end && (*cursor == first || *cursor == second || *cursor == third) != stop_on_match) {
+        cursor++;
+    }
+    return cursor;
+}
+
+#ifdef LEXER_X86_SIMD
+/* Compares 16 bytes per step against the three bytes, then finds the first hit in the movemask */
+__attribute__((target("sse2")))
+static const char *scan_bytes_sse2(const char *cursor, const char *end, char first, char second, char third, bool stop_on_match){
+    const __m128i first_bytes = _mm_set1_epi8(first);
+    const __m128i second_bytes = _mm_set1_epi8(second);
+    const __m128i third_bytes = _mm_set1_epi8(third);
+    const unsigned int flip = stop_on_match ? 0 : 0xFFFFu;
+
+    while (end - cursor >= 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i *)cursor);
+        __m128i hits = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, first_bytes), _mm_cmpeq_epi8(chunk, second_bytes)),
+                                    _mm_cmpeq_epi8(chunk, third_bytes));
+        unsigned int mask = ((unsigned int)_mm_movemask_epi8(hits)) ^ flip;
+
+        if (mask != 0)
+            return cursor + __builtin_ctz(mask);
+        cursor += 16;
+    }
+
+    return scan_bytes_scalar(cursor, end, first, second, third, stop_on_match);
+}
+
+/* Same as the SSE2 kernel, 32 bytes per step */
+__attribute__((target("avx2")))
+static const char *scan_bytes_avx2(const char *cursor, const char *end, char first, char second, char third, bool stop_on_match){
+    const __m256i first_bytes = _mm256_set1_epi8(first);
+    const __m256i second_bytes = _mm256_set1_epi8(second);
+    const __m256i third_bytes = _mm256_set1_epi8(third);
+    const unsigned int flip = stop_on_match ? 0 : 0xFFFFFFFFu;
+
+    while (end - cursor >= 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i *)cursor);
+        __m256i hits = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, first_bytes), _mm256_cmpeq_epi8(chunk, second_bytes)),
+                                       _mm256_cmpeq_epi8(chunk, third_bytes));
+        unsigned int mask = ((unsigned int)_mm256_movemask_epi8(hits)) ^ flip;
+
+        if (mask != 0)
+            return cursor + __builtin_ctz(mask);
+        cursor += 32;
+    }
+
+    return scan_bytes_sse2(cursor, end, first, second, third, stop_on_match);
+}
+#endif
+
+/* Picks the widest scanner the running CPU supports (the check is a cached flag test, no global state is written) */
+static ByteScanner select_byte_scanner(void){
+#ifdef LEXER_X86_SIMD
+    if (__builtin_cpu_supports("avx2"))
+        return scan_bytes_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return scan_bytes_sse2;
+#endif
+    return scan_bytes_scalar;
+}
 
 static bool is_valid_macro_char(char ch){
     return isalnum(ch) || ch == '_';
@@ -1,6 +1,28 @@
+/* Range parsing runs its ranges on POSIX threads when built with -DPARSER_THREADS (and -pthread) */
+#ifdef PARSER_THREADS
+#define _POSIX_C_SOURCE 200112L
+#endif
+
 #include "../headers/safe_allocations.h"
 #include "../headers/nodes.h"
 #include "../headers/parser.h"
+#ifdef PARSER_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#define MAX_PARSER_THREADS 16
+#define MIN_RANGE_TOKENS (64 * 1024) /* Smaller ranges cost more in thread start-up and joining than they save */
+
+/* One range of statements parsed on its own, a view of the parent unit's tokens with its own lists, rows and errors */
+typedef struct ParserRange {
+    TranslationUnit unit; /* Parses the range, its token count ends at the range's end */
+    unsigned int first_row; /* Row of the parent's instruction table the range's rows are written from */
+#ifdef PARSER_THREADS
+    pthread_t thread; /* The thread parsing the range */
+    bool threaded; /* The thread was started (otherwise the range is parsed when it is joined) */
+#endif
+} ParserRange;
 
 static InstructionOperand parse_operand(TranslationUnit *unit, bool *has_error);
 
@@ -8,10 +30,40 @@ static void report_error(TranslationUnit *unit, const char *message, Token *toke
 
 static bool is_instruction_token(TokenType type);
 
-static void append_token_to_list(TokenReferenceNode **list, Token *token);
+static Token *current_token(TranslationUnit *unit);
+
+static Token *peek_token(TranslationUnit *unit, unsigned int offset);
+
+static void advance_token(TranslationUnit *unit);
+
+static void initialize_instruction_table(TranslationUnit *unit);
+
+static void parse_instruction_rows(TranslationUnit *unit);
 
+static AddressingMode operand_addressing_mode(Token *operand, bool is_dereferenced);
 
-void parser_initialize_translation_unit(TranslationUnit *unit, Lexer lexer) {
+static void parse_statements(TranslationUnit *unit);
+
+static unsigned int thread_range_count(TranslationUnit *unit);
+
+static bool is_range_start(TranslationUnit *unit, unsigned int index);
+
+static unsigned int cut_ranges(TranslationUnit *unit, ParserRange *ranges, unsigned int range_count);
+
+static void *parse_range(void *range);
+
+static void join_range(TranslationUnit *unit, ParserRange *range);
+
+/* About one node is made per few tokens, so most units fit in the arena's first slab */
+#define ARENA_BYTES_PER_TOKEN 16
+#define MIN_ARENA_SLAB_SIZE 4096
+
+/* An instruction table row is one entry of each of its nine arrays, each array is rounded up to the arena's alignment */
+#define INSTRUCTION_ROW_BYTES (4 * sizeof(unsigned char) + 2 * sizeof(int) + 3 * sizeof(unsigned int))
+#define INSTRUCTION_TABLE_PADDING (9 * 16)
+
+
+void parser_initialize_translation_unit(TranslationUnit *unit, Lexer *lexer) {
     if (unit == NULL) {
         fprintf(stderr, "Error: Null translation unit pointer\n");
         return;
@@ -24,51 +76,25 @@ void parser_initialize_translation_unit(TranslationUnit *unit, Lexer lexer) {
     unit->guidance_label_list = NULL;
 
     /* Set the tokens from the lexer */
-    unit->tokens = lexer.token_list;
+    unit->tokens = lexer->tokens;
+    unit->current = 0;
+    initialize_instruction_table(unit);
 
     /* Initialize the error handler */
-    error_handler_initialize(&unit->error_handler, lexer.source_code, lexer.file_path);
+    error_handler_initialize(&unit->error_handler, lexer->source_code, &lexer->line_index, lexer->file_path);
 
     /* Optional: Print debug information */
 #ifdef DEBUG
-    printf("Translation unit initialized with %d tokens\n", count_tokens(lexer.tokens));
+    printf("Translation unit initialized with %u tokens\n", lexer->tokens.count);
 #endif
 }
 
 void parser_free_translation_unit(TranslationUnit *unit) {
-    void *temp;
     if (unit == NULL)
         return;
 
-    /* Free externalNodes */
-    while (unit->external_list) {
-        temp = unit->external_list->next;
-        free(unit->external_list);
-        unit->external_list = temp;
-    }
-
-    /* Free entryNodes */
-    while (unit->entry_list) {
-        temp = unit->entry_list->next;
-        free(unit->entry_list);
-        unit->entry_list = temp;
-    }
-
-    /* Free instructionLabels */
-    while (unit->instruction_label_list) {
-        parser_free_instruction_list(unit->instruction_label_list->label.instruction_list);
-        temp = unit->instruction_label_list->next;
-        free(unit->instruction_label_list);
-        unit->instruction_label_list = temp;
-    }
-
-    /* Free guidanceLabels */
-    while (unit->guidance_label_list) {
-        parser_free_guidance_list(unit->guidance_label_list->label.guidance_list);
-        temp = unit->guidance_label_list->next;
-        free(unit->guidance_label_list);
-        unit->guidance_label_list = temp;
-    }
+    /* Every node of every list is in the arena, so there is no list to walk */
+    arena_free(&unit->arena);
 
     /* Free the error handler */
     error_handler_free(&unit->error_handler);
@@ -81,18 +107,18 @@ void parser_free_translation_unit(TranslationUnit *unit) {
 }
 
 void parser_move_to_end_of_line(TranslationUnit *unit) {
-    if (unit == NULL || unit->tokens == NULL) {
+    if (unit == NULL || current_token(unit) == NULL) {
         return; /* Handle null pointer or empty token list */
     }
 
-    while (unit->tokens && unit->tokens->token.type != TOKEN_EOL &&
-           unit->tokens->token.type != TOKEN_EOFT) {
-        unit->tokens = unit->tokens->next;
+    while (current_token(unit) && current_token(unit)->type != TOKEN_EOL &&
+           current_token(unit)->type != TOKEN_EOFT) {
+        advance_token(unit);
     }
 
     /* Move past the EOL token if it's not the end of file */
-    if (unit->tokens && unit->tokens->token.type == TOKEN_EOL) {
-        unit->tokens = unit->tokens->next;
+    if (current_token(unit) && current_token(unit)->type == TOKEN_EOL) {
+        advance_token(unit);
     }
 }
 
@@ -100,11 +126,13 @@ DataNode parse_data_directive_guidance(TranslationUnit *unit) {
     DataNode data_node = {NULL};
     TokenError error;
     Token default_token;
+    Token *number;
+    unsigned int capacity;
 
     /* Initialize default_token */
     memset(&default_token, 0, sizeof(Token));
 
-    if (unit == NULL || unit->tokens == NULL) {
+    if (unit == NULL || current_token(unit) == NULL) {
         error.message = string_create_from_cstr("Expected .data directive, but got null pointer");
         error.token = default_token; /* Initialize with a default token */
         if (unit != NULL) {
@@ -117,32 +145,51 @@ DataNode parse_data_directive_guidance(TranslationUnit *unit) {
         return data_node;
     }
 
-    if (unit->tokens->token.type != TOKEN_DATA_INS) {
+    if (current_token(unit)->type != TOKEN_DATA_INS) {
         error.message = string_create_from_cstr("Expected .data directive");
-        error.token = unit->tokens->token;
+        error.token = *current_token(unit);
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(unit);
         return data_node;
     }
 
-    unit->tokens = unit->tokens->next;
+    advance_token(unit);
 
-    while (unit->tokens && unit->tokens->token.type != TOKEN_EOFT) {
-        if (unit->tokens->token.type == TOKEN_NUMBER) {
-            append_token_to_list(&data_node.data_numbers, &unit->tokens->token);
-            unit->tokens = unit->tokens->next;
+    /* Count the numbers ahead so the values are packed in one block of the arena */
+    capacity = 0;
+    for (number = current_token(unit); number != NULL &&
+         (number->type == TOKEN_NUMBER || number->type == TOKEN_COMMA); number++) {
+        if (number->type == TOKEN_NUMBER)
+            capacity++;
+    }
+    if (capacity > 0) {
+        data_node.numbers = arena_allocate(&unit->arena, capacity * sizeof(short));
+        data_node.first_number = current_token(unit);
+    }
 
-            if (unit->tokens == NULL) break;
+    while (current_token(unit) && current_token(unit)->type != TOKEN_EOFT) {
+        if (current_token(unit)->type == TOKEN_NUMBER) {
+            number = current_token(unit);
+            if (number->is_overflow || number->value > MAX_15BIT_SIGNED_INT || number->value < MIN_15BIT_SIGNED_INT) {
+                /* Left for the semantic analyzer to report, which finds it through first_number */
+                data_node.is_out_of_range = true;
+                data_node.numbers[data_node.count++] = 0;
+            } else {
+                data_node.numbers[data_node.count++] = (short) number->value;
+            }
+            advance_token(unit);
 
-            if (unit->tokens->token.type == TOKEN_COMMA) {
-                unit->tokens = unit->tokens->next;
-            } else if (unit->tokens->token.type == TOKEN_EOL) {
-                unit->tokens = unit->tokens->next;
+            if (current_token(unit) == NULL) break;
+
+            if (current_token(unit)->type == TOKEN_COMMA) {
+                advance_token(unit);
+            } else if (current_token(unit)->type == TOKEN_EOL) {
+                advance_token(unit);
                 break;
-            } else if (unit->tokens->token.type != TOKEN_EOFT) {
+            } else if (current_token(unit)->type != TOKEN_EOFT) {
                 error.message = string_create_from_cstr(
                     "Expected comma or end of line after number in .data directive");
-                error.token = unit->tokens->token;
+                error.token = *current_token(unit);
                 error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
                 parser_move_to_end_of_line(unit);
                 data_node.has_parser_error = true;
@@ -150,7 +197,7 @@ DataNode parse_data_directive_guidance(TranslationUnit *unit) {
             }
         } else {
             error.message = string_create_from_cstr("Expected number in .data directive");
-            error.token = unit->tokens->token;
+            error.token = *current_token(unit);
             error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
             parser_move_to_end_of_line(unit);
             data_node.has_parser_error = true;
@@ -158,9 +205,9 @@ DataNode parse_data_directive_guidance(TranslationUnit *unit) {
         }
     }
 
-    if (data_node.data_numbers == NULL) {
+    if (data_node.count == 0) {
         error.message = string_create_from_cstr("No numbers found in .data directive");
-        error.token = unit->tokens ? unit->tokens->token : default_token;
+        error.token = current_token(unit) ? *current_token(unit) : default_token;
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         data_node.has_parser_error = true;
     }
@@ -170,13 +217,8 @@ DataNode parse_data_directive_guidance(TranslationUnit *unit) {
 
 
 void parser_free_directive_guidance(DataNode data_node) {
-    TokenReferenceNode *head = data_node.data_numbers;
-
-    while (head != NULL) {
-        TokenReferenceNode *temp = head;
-        head = head->next;
-        free(temp);
-    }
+    /* The numbers are released with the unit's arena */
+    (void) data_node;
 }
 
 StringNode parse_string_directive_guidance(TranslationUnit *unit) {
@@ -187,7 +229,7 @@ StringNode parse_string_directive_guidance(TranslationUnit *unit) {
     /* Initialize default_token */
     memset(&default_token, 0, sizeof(Token));
 
-    if (unit == NULL || unit->tokens == NULL) {
+    if (unit == NULL || current_token(unit) == NULL) {
         error.message = string_create_from_cstr("Expected .string directive, but got null pointer");
         error.token = default_token; /* Initialize with a default token */
         if (unit != NULL) {
@@ -199,40 +241,40 @@ StringNode parse_string_directive_guidance(TranslationUnit *unit) {
         return string_node;
     }
 
-    if (unit->tokens->token.type != TOKEN_STRING_INS) {
+    if (current_token(unit)->type != TOKEN_STRING_INS) {
         error.message = string_create_from_cstr("Expected .string directive");
-        error.token = unit->tokens->token;
+        error.token = *current_token(unit);
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(unit);
         string_node.has_parser_error = true;
         return string_node;
     }
 
-    unit->tokens = unit->tokens->next; /* Move past .string token */
+    advance_token(unit); /* Move past .string token */
 
-    if (unit->tokens == NULL || unit->tokens->token.type != TOKEN_STRING) {
+    if (current_token(unit) == NULL || current_token(unit)->type != TOKEN_STRING) {
         error.message = string_create_from_cstr("Expected string after .string directive");
-        error.token = unit->tokens ? unit->tokens->token : default_token;
+        error.token = current_token(unit) ? *current_token(unit) : default_token;
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(unit);
         string_node.has_parser_error = true;
         return string_node;
     }
 
-    string_node.string_label = &unit->tokens->token;
-    unit->tokens = unit->tokens->next; /* Move past string token */
+    string_node.string_label = current_token(unit);
+    advance_token(unit); /* Move past string token */
 
     /* Check for end of line */
-    if (unit->tokens != NULL &&
-        unit->tokens->token.type != TOKEN_EOL &&
-        unit->tokens->token.type != TOKEN_EOFT) {
+    if (current_token(unit) != NULL &&
+        current_token(unit)->type != TOKEN_EOL &&
+        current_token(unit)->type != TOKEN_EOFT) {
         error.message = string_create_from_cstr("Unexpected tokens after string in .string directive");
-        error.token = unit->tokens->token;
+        error.token = *current_token(unit);
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(unit);
         string_node.has_parser_error = true;
-    } else if (unit->tokens != NULL && unit->tokens->token.type == TOKEN_EOL) {
-        unit->tokens = unit->tokens->next; /* Move past EOL token */
+    } else if (current_token(unit) != NULL && current_token(unit)->type == TOKEN_EOL) {
+        advance_token(unit); /* Move past EOL token */
     }
 
     return string_node;
@@ -242,34 +284,20 @@ GuidanceNodeList *parser_parse_guidance_list(TranslationUnit *unit) {
     GuidanceNodeList *guidance_node_list = NULL;
     GuidanceNodeList **guidanceListLast = &guidance_node_list; /* Pointer to the last node in the guidanceList */
 
-    while (unit->tokens != NULL && unit->tokens->token.type != TOKEN_EOFT) {
-        if (unit->tokens->token.type == TOKEN_EOL) {
-            unit->tokens = unit->tokens->next; /* Skip empty lines */
-        } else if (unit->tokens->token.type == TOKEN_DATA_INS ||
-                   unit->tokens->token.type == TOKEN_STRING_INS) {
+    while (current_token(unit) != NULL && current_token(unit)->type != TOKEN_EOFT) {
+        if (current_token(unit)->type == TOKEN_EOL) {
+            advance_token(unit); /* Skip empty lines */
+        } else if (current_token(unit)->type == TOKEN_DATA_INS ||
+                   current_token(unit)->type == TOKEN_STRING_INS) {
             /* Parse .data or .string directive */
-            GuidanceNodeList *newNode;
-
-            if (guidance_node_list == NULL) {
-                /* First guidance directive encountered */
-                newNode = guidance_node_list = malloc(sizeof(GuidanceNodeList));
-            } else {
-                /* Append to existing list */
-                newNode = (*guidanceListLast)->next = malloc(sizeof(GuidanceNodeList));
-                guidanceListLast = &((*guidanceListLast)->next);
-            }
-
-            if (newNode == NULL) {
-                /* Handle memory allocation failure */
-                fprintf(stderr, "Memory allocation failed in parse_guidance_directives\n");
-                /* Consider adding proper error handling and cleanup here */
-                return guidance_node_list;
-            }
+            GuidanceNodeList *newNode = arena_allocate(&unit->arena, sizeof(GuidanceNodeList));
 
+            /* Link the node in place of the list's terminating NULL */
             newNode->next = NULL;
+            *guidanceListLast = newNode;
 
             /* Parse specific directive type */
-            if (unit->tokens->token.type == TOKEN_DATA_INS) {
+            if (current_token(unit)->type == TOKEN_DATA_INS) {
                 newNode->type = DATA_NODE;
                 newNode->node.dataNode = parse_data_directive_guidance(unit);
             } else {
@@ -277,7 +305,7 @@ GuidanceNodeList *parser_parse_guidance_list(TranslationUnit *unit) {
                 newNode->node.stringNode = parse_string_directive_guidance(unit);
             }
 
-            guidanceListLast = &newNode;
+            guidanceListLast = &newNode->next;
         } else {
             /* Non-guidance token encountered, end of guidance section */
             break;
@@ -288,23 +316,8 @@ GuidanceNodeList *parser_parse_guidance_list(TranslationUnit *unit) {
 }
 
 void parser_free_guidance_list(GuidanceNodeList *guidance_list) {
-    GuidanceNodeList *current;
-    if (guidance_list == NULL) {
-        return; /* Nothing to free if the list is already NULL */
-    }
-
-    while (guidance_list != NULL) {
-        current = guidance_list;
-        guidance_list = guidance_list->next;
-
-        /* Free the specific guidance node based on its type */
-        if (current->type == DATA_NODE) {
-            parser_free_directive_guidance(current->node.dataNode);
-        }
-
-        /* Free the current GuidanceNodeList node */
-        free(current);
-    }
+    /* The nodes are released with the unit's arena */
+    (void) guidance_list;
 }
 
 void parser_free_sentences(AssemblyStatementList *statement_list) {
@@ -334,21 +347,21 @@ InstructionNode parser_parse_instruction(TranslationUnit *unit) {
     memset(&default_token, 0, sizeof(Token));
 
     /* Check if the current token is a valid instruction */
-    if (unit->tokens == NULL || !is_instruction_token(unit->tokens->token.type)) {
+    if (current_token(unit) == NULL || !is_instruction_token(current_token(unit)->type)) {
         error.message = string_create_from_cstr("Expected an instruction");
-        error.token = unit->tokens ? unit->tokens->token : default_token;
+        error.token = current_token(unit) ? *current_token(unit) : default_token;
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(unit);
         instruction.has_parser_error = true;
         return instruction;
     }
 
-    instruction.operation = &unit->tokens->token;
-    unit->tokens = unit->tokens->next; /* Move past the instruction token */
+    instruction.operation = current_token(unit);
+    advance_token(unit); /* Move past the instruction token */
 
     /* Check if it's a zero-operand instruction */
-    if (unit->tokens == NULL || unit->tokens->token.type == TOKEN_EOL ||
-        unit->tokens->token.type == TOKEN_EOFT) {
+    if (current_token(unit) == NULL || current_token(unit)->type == TOKEN_EOL ||
+        current_token(unit)->type == TOKEN_EOFT) {
         return instruction;
     }
 
@@ -363,22 +376,22 @@ InstructionNode parser_parse_instruction(TranslationUnit *unit) {
     instruction.is_first_operand_derefrenced = first_operand.is_dereferenced;
 
     /* Check if it's a one-operand instruction */
-    if (unit->tokens == NULL || unit->tokens->token.type == TOKEN_EOL ||
-        unit->tokens->token.type == TOKEN_EOFT) {
+    if (current_token(unit) == NULL || current_token(unit)->type == TOKEN_EOL ||
+        current_token(unit)->type == TOKEN_EOFT) {
         instruction.has_parser_error |= error_in_operand;
         return instruction;
     }
 
     /* Check for comma separator between operands */
-    if (unit->tokens->token.type != TOKEN_COMMA) {
+    if (current_token(unit)->type != TOKEN_COMMA) {
         error.message = string_create_from_cstr("Expected comma between operands");
-        error.token = unit->tokens->token;
+        error.token = *current_token(unit);
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(unit);
         instruction.has_parser_error = true;
         return instruction;
     }
-    unit->tokens = unit->tokens->next; /* Move past the comma */
+    advance_token(unit); /* Move past the comma */
 
     /* Parse second operand */
     second_operand = parse_operand(unit, &error_in_operand);
@@ -391,10 +404,10 @@ InstructionNode parser_parse_instruction(TranslationUnit *unit) {
     instruction.is_second_operand_derefrenced = second_operand.is_dereferenced;
 
     /* Check for end of line */
-    if (unit->tokens && unit->tokens->token.type != TOKEN_EOL &&
-        unit->tokens->token.type != TOKEN_EOFT) {
+    if (current_token(unit) && current_token(unit)->type != TOKEN_EOL &&
+        current_token(unit)->type != TOKEN_EOFT) {
         error.message = string_create_from_cstr("Expected end of line after instruction");
-        error.token = unit->tokens->token;
+        error.token = *current_token(unit);
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(unit);
         instruction.has_parser_error = true;
@@ -408,33 +421,20 @@ InstructionNodeList *parser_parse_instruction_list(TranslationUnit *unit) {
     InstructionNodeList *instructionList = NULL;
     InstructionNodeList **instructionListLast = &instructionList; /* Pointer to the last node in the instructionList */
 
-    while (unit->tokens != NULL && unit->tokens->token.type != TOKEN_EOFT) {
-        if (unit->tokens->token.type == TOKEN_EOL) {
-            unit->tokens = unit->tokens->next; /* Skip empty lines */
-        } else if (is_instruction_token(unit->tokens->token.type)) {
+    while (current_token(unit) != NULL && current_token(unit)->type != TOKEN_EOFT) {
+        if (current_token(unit)->type == TOKEN_EOL) {
+            advance_token(unit); /* Skip empty lines */
+        } else if (is_instruction_token(current_token(unit)->type)) {
             /* Parse instruction */
-            InstructionNodeList *newNode;
-
-            if (instructionList == NULL) {
-                /* First instruction encountered */
-                newNode = instructionList = malloc(sizeof(InstructionNodeList));
-            } else {
-                /* Append to existing list */
-                newNode = (*instructionListLast)->next = malloc(sizeof(InstructionNodeList));
-                instructionListLast = &((*instructionListLast)->next);
-            }
-
-            if (newNode == NULL) {
-                /* Handle memory allocation failure */
-                fprintf(stderr, "Memory allocation failed in parse_instructions\n");
-                /* Consider adding proper error handling and cleanup here*/
-                return instructionList;
-            }
+            InstructionNodeList *newNode = arena_allocate(&unit->arena, sizeof(InstructionNodeList));
 
+            /* Link the node in place of the list's terminating NULL */
             newNode->next = NULL;
+            *instructionListLast = newNode;
             newNode->node = parser_parse_instruction(unit);
+            parser_append_instruction_row(&unit->instructions, unit->tokens.data, newNode->node);
 
-            instructionListLast = &newNode;
+            instructionListLast = &newNode->next;
         } else {
             /* Non-instruction token encountered, end of instruction section */
             break;
@@ -444,68 +444,115 @@ InstructionNodeList *parser_parse_instruction_list(TranslationUnit *unit) {
     return instructionList;
 }
 
-void parser_free_instruction_list(InstructionNodeList *instruction_list) {
-    InstructionNodeList *current;
+/* Parses consecutive instructions straight into the unit's instruction table, with no list node for them */
+static void parse_instruction_rows(TranslationUnit *unit) {
+    InstructionNode instruction;
 
-    if (instruction_list == NULL) {
-        return; /* Nothing to free if the list is already NULL */
+    while (current_token(unit) != NULL && current_token(unit)->type != TOKEN_EOFT) {
+        if (current_token(unit)->type == TOKEN_EOL) {
+            advance_token(unit); /* Skip empty lines */
+        } else if (is_instruction_token(current_token(unit)->type)) {
+            instruction = parser_parse_instruction(unit);
+            parser_append_instruction_row(&unit->instructions, unit->tokens.data, instruction);
+        } else {
+            break; /* Non-instruction token encountered, end of instruction section */
+        }
     }
+}
 
+void parser_append_instruction_row(InstructionTable *table, Token *tokens, InstructionNode node) {
+    unsigned int row;
+    Token *source = NULL;
+    Token *destination = NULL;
+    bool is_source_dereferenced = false;
+    bool is_destination_dereferenced = false;
 
-    while (instruction_list != NULL) {
-        current = instruction_list;
-        instruction_list = instruction_list->next;
+    if (table == NULL || node.operation == NULL || table->count >= table->capacity)
+        return;
 
-        /* Free any dynamically allocated memory within the instruction node if necessary */
-        /* For example, if operands are dynamically allocated:
-        if (current->node.firstOperand) free(current->node.firstOperand);
-        if (current->node.secondOperand) free(current->node.secondOperand);
-        */
+    /* A lone operand is the destination, as the instruction word encodes it */
+    if (node.second_operand != NULL) {
+        source = node.first_operand;
+        is_source_dereferenced = node.is_first_operand_derefrenced;
+        destination = node.second_operand;
+        is_destination_dereferenced = node.is_second_operand_derefrenced;
+    } else {
+        destination = node.first_operand;
+        is_destination_dereferenced = node.is_first_operand_derefrenced;
+    }
+
+    row = table->count++;
+    table->opcode[row] = (unsigned char) (node.operation->type - TOKEN_MOV);
+    table->token[row] = (unsigned int) (node.operation - tokens);
+    table->flags[row] = 0;
+
+    table->source_mode[row] = 0;
+    table->source_value[row] = 0;
+    table->source_token[row] = 0;
+    if (source != NULL) {
+        table->source_mode[row] = (unsigned char) operand_addressing_mode(source, is_source_dereferenced);
+        table->source_value[row] = source->value;
+        table->source_token[row] = (unsigned int) (source - tokens);
+        if (is_source_dereferenced)
+            table->flags[row] |= INSTRUCTION_SOURCE_DEREFERENCED;
+    }
 
-        /* Free the current InstructionNodeList node */
-        free(current);
+    table->destination_mode[row] = 0;
+    table->destination_value[row] = 0;
+    table->destination_token[row] = 0;
+    if (destination != NULL) {
+        table->destination_mode[row] = (unsigned char) operand_addressing_mode(destination, is_destination_dereferenced);
+        table->destination_value[row] = destination->value;
+        table->destination_token[row] = (unsigned int) (destination - tokens);
+        if (is_destination_dereferenced)
+            table->flags[row] |= INSTRUCTION_DESTINATION_DEREFERENCED;
     }
 }
 
+void parser_free_instruction_list(InstructionNodeList *instruction_list) {
+    /* The nodes are released with the unit's arena */
+    (void) instruction_list;
+}
+
 EntryNode parser_parse_entry(TranslationUnit *translation_unit) {
     EntryNode node = {NULL};
     TokenError error;
 
     /* Check for .entry directive */
-    if (translation_unit->tokens == NULL || translation_unit->tokens->token.type != TOKEN_ENTRY_INS) {
+    if (current_token(translation_unit) == NULL || current_token(translation_unit)->type != TOKEN_ENTRY_INS) {
         error.message = string_create_from_cstr("Expected .entry directive");
-        error.token = translation_unit->tokens->token;
+        error.token = *current_token(translation_unit);
         error_handler_add_token_error(&translation_unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(translation_unit);
         node.has_parser_error = true;
         return node;
     }
 
-    translation_unit->tokens = translation_unit->tokens->next; /* Move past .entry token */
+    advance_token(translation_unit); /* Move past .entry token */
 
     /* Check for identifier after .entry */
-    if (translation_unit->tokens == NULL || translation_unit->tokens->token.type != TOKEN_IDENTIFIER) {
+    if (current_token(translation_unit) == NULL || current_token(translation_unit)->type != TOKEN_IDENTIFIER) {
         error.message = string_create_from_cstr("Expected identifier after .entry directive");
-        error.token = translation_unit->tokens->token;
+        error.token = *current_token(translation_unit);
         error_handler_add_token_error(&translation_unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(translation_unit);
         node.has_parser_error = true;
         return node;
     }
 
-    node.entry_label = &translation_unit->tokens->token;
-    translation_unit->tokens = translation_unit->tokens->next; /* Move past identifier token */
+    node.entry_label = current_token(translation_unit);
+    advance_token(translation_unit); /* Move past identifier token */
 
     /* Check for end of line */
-    if (translation_unit->tokens && translation_unit->tokens->token.type != TOKEN_EOL &&
-        translation_unit->tokens->token.type != TOKEN_EOFT) {
+    if (current_token(translation_unit) && current_token(translation_unit)->type != TOKEN_EOL &&
+        current_token(translation_unit)->type != TOKEN_EOFT) {
         error.message = string_create_from_cstr("Unexpected tokens after .entry identifier");
-        error.token = translation_unit->tokens->token;
+        error.token = *current_token(translation_unit);
         error_handler_add_token_error(&translation_unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(translation_unit);
         node.has_parser_error = true;
-    } else if (translation_unit->tokens && translation_unit->tokens->token.type == TOKEN_EOL) {
-        translation_unit->tokens = translation_unit->tokens->next; /* Move past EOL token */
+    } else if (current_token(translation_unit) && current_token(translation_unit)->type == TOKEN_EOL) {
+        advance_token(translation_unit); /* Move past EOL token */
     }
 
     return node;
@@ -520,40 +567,40 @@ ExternalNode parser_parse_external(TranslationUnit *unit) {
     memset(&default_token, 0, sizeof(Token));
 
     /* Check for .extern directive */
-    if (unit->tokens == NULL || unit->tokens->token.type != TOKEN_EXTERN_INS) {
+    if (current_token(unit) == NULL || current_token(unit)->type != TOKEN_EXTERN_INS) {
         error.message = string_create_from_cstr("Expected .extern directive");
-        error.token = unit->tokens ? unit->tokens->token : default_token;
+        error.token = current_token(unit) ? *current_token(unit) : default_token;
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(unit);
         node.has_parser_error = true;
         return node;
     }
 
-    unit->tokens = unit->tokens->next; /*  past .extern token */
+    advance_token(unit); /*  past .extern token */
 
     /* Check for identifier after .extern */
-    if (unit->tokens == NULL || unit->tokens->token.type != TOKEN_IDENTIFIER) {
+    if (current_token(unit) == NULL || current_token(unit)->type != TOKEN_IDENTIFIER) {
         error.message = string_create_from_cstr("Expected identifier after .extern directive");
-        error.token = unit->tokens ? unit->tokens->token : default_token;
+        error.token = current_token(unit) ? *current_token(unit) : default_token;
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(unit);
         node.has_parser_error = true;
         return node;
     }
 
-    node.external_label = &unit->tokens->token;
-    unit->tokens = unit->tokens->next; /* Move past identifier token */
+    node.external_label = current_token(unit);
+    advance_token(unit); /* Move past identifier token */
 
     /* Check for end of line */
-    if (unit->tokens && unit->tokens->token.type != TOKEN_EOL &&
-        unit->tokens->token.type != TOKEN_EOFT) {
+    if (current_token(unit) && current_token(unit)->type != TOKEN_EOL &&
+        current_token(unit)->type != TOKEN_EOFT) {
         error.message = string_create_from_cstr("Unexpected tokens after .extern identifier");
-        error.token = unit->tokens->token;
+        error.token = *current_token(unit);
         error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
         parser_move_to_end_of_line(unit);
         node.has_parser_error = true;
-    } else if (unit->tokens && unit->tokens->token.type == TOKEN_EOL) {
-        unit->tokens = unit->tokens->next; /* Move past EOL token */
+    } else if (current_token(unit) && current_token(unit)->type == TOKEN_EOL) {
+        advance_token(unit); /* Move past EOL token */
     }
 
     return node;
@@ -570,34 +617,34 @@ LabelNode parse_labeled_statement(TranslationUnit *unit) {
     memset(&default_token, 0, sizeof(Token));
 
     /* Check for label identifier */
-    if (unit->tokens != NULL && unit->tokens->token.type == TOKEN_IDENTIFIER) {
-        label.label = &unit->tokens->token;
-        unit->tokens = unit->tokens->next; /* Move over the label identifier */
+    if (current_token(unit) != NULL && current_token(unit)->type == TOKEN_IDENTIFIER) {
+        label.label = current_token(unit);
+        advance_token(unit); /* Move over the label identifier */
 
         /* Check for colon after label identifier */
-        if (unit->tokens == NULL || unit->tokens->token.type != TOKEN_COLON) {
+        if (current_token(unit) == NULL || current_token(unit)->type != TOKEN_COLON) {
             error.message = string_create_from_cstr("No colon found after label identifier");
-            error.token = unit->tokens ? unit->tokens->token : default_token;
+            error.token = current_token(unit) ? *current_token(unit) : default_token;
             error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
             parser_move_to_end_of_line(unit);
             return label;
         }
 
         /* Check if colon is immediately after label identifier */
-        if (label.label->index + string_length(label.label->string) != unit->tokens->token.index) {
+        if (label.label->index + label.label->length != current_token(unit)->index) {
             error.message = string_create_from_cstr("The colon should be immediately after the label identifier");
-            error.token = unit->tokens->token;
+            error.token = *current_token(unit);
             error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
             parser_move_to_end_of_line(unit);
             return label;
         }
 
-        unit->tokens = unit->tokens->next; /* Move over the colon token */
+        advance_token(unit); /* Move over the colon token */
 
         /* Skip EOL tokens after the colon */
-        while (unit->tokens != NULL && unit->tokens->token.type != TOKEN_EOFT) {
-            if (unit->tokens->token.type == TOKEN_EOL)
-                unit->tokens = unit->tokens->next;
+        while (current_token(unit) != NULL && current_token(unit)->type != TOKEN_EOFT) {
+            if (current_token(unit)->type == TOKEN_EOL)
+                advance_token(unit);
             else
                 break;
         }
@@ -606,23 +653,25 @@ LabelNode parse_labeled_statement(TranslationUnit *unit) {
     }
 
     /* Parse instruction or guidance after label */
-    if (unit->tokens != NULL) {
-        if (is_instruction_token(unit->tokens->token.type)) {
+    if (current_token(unit) != NULL) {
+        if (is_instruction_token(current_token(unit)->type)) {
             if (!label_identifier_found) {
                 error.message = string_create_from_cstr("An instruction was found here but no label identifier, "
                     "please add a label identifier");
-                error.token = unit->tokens->token;
+                error.token = *current_token(unit);
                 error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
                 parser_move_to_end_of_line(unit);
                 return label;
             }
-            label.instruction_list = parser_parse_instruction_list(unit);
-        } else if (unit->tokens->token.type == TOKEN_STRING_INS ||
-                   unit->tokens->token.type == TOKEN_DATA_INS) {
+            label.first_instruction = unit->instructions.count;
+            parse_instruction_rows(unit);
+            label.instruction_count = unit->instructions.count - label.first_instruction;
+        } else if (current_token(unit)->type == TOKEN_STRING_INS ||
+                   current_token(unit)->type == TOKEN_DATA_INS) {
             label.guidance_list = parser_parse_guidance_list(unit);
         } else {
             error.message = string_create_from_cstr("No instruction/guidance was found here");
-            error.token = unit->tokens->token;
+            error.token = *current_token(unit);
             error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
             parser_move_to_end_of_line(unit);
         }
@@ -632,6 +681,55 @@ LabelNode parse_labeled_statement(TranslationUnit *unit) {
 }
 
 void parse_translation_unit_content(TranslationUnit *unit) {
+    unsigned int range_count = thread_range_count(unit);
+
+    if (range_count > 1 && unit->current == 0) {
+        parser_parse_ranges(unit, range_count);
+        return;
+    }
+    parse_statements(unit);
+}
+
+void parser_parse_ranges(TranslationUnit *unit, unsigned int range_count) {
+    ParserRange *ranges;
+    unsigned int i;
+
+    if (range_count < 1)
+        range_count = 1;
+    if (range_count > MAX_PARSER_THREADS)
+        range_count = MAX_PARSER_THREADS;
+    ranges = safe_malloc(range_count * sizeof(ParserRange));
+    range_count = cut_ranges(unit, ranges, range_count);
+
+    /* Every range but the first is parsed on its own thread, the first one is parsed on this thread meanwhile */
+#ifdef PARSER_THREADS
+    for (i = 1; i < range_count; i++) {
+        ranges[i].threaded = pthread_create(&ranges[i].thread, NULL, parse_range, &ranges[i]) == 0;
+    }
+#endif
+    parse_range(&ranges[0]);
+    join_range(unit, &ranges[0]);
+
+    for (i = 1; i < range_count; i++) {
+#ifdef PARSER_THREADS
+        if (ranges[i].threaded)
+            pthread_join(ranges[i].thread, NULL);
+        else
+#endif
+            parse_range(&ranges[i]);
+        join_range(unit, &ranges[i]);
+    }
+
+    unit->current = ranges[range_count - 1].unit.current; /* Where the last range stopped, on the EOF token */
+    free(ranges);
+}
+
+/**
+ * Parse the statements from the parser cursor to the end of the unit's tokens (or its EOF token)
+ *
+ * @param unit the translation unit.
+ */
+static void parse_statements(TranslationUnit *unit) {
     ExternalNodeList *external_node_list = NULL;
     ExternalNodeList **external_node_list_last = &external_node_list;
     EntryNodeList *entry_node_list = NULL;
@@ -646,69 +744,54 @@ void parse_translation_unit_content(TranslationUnit *unit) {
     /*printf("Debug: Starting parsing of translation unit...\n");*/
 
 
-    while (unit->tokens != NULL && unit->tokens->token.type != TOKEN_EOFT) {
-        /*printf("Debug: Processing token of type %d at index %d\n", unit->tokens->token.type, unit->tokens->token.index);*/
+    while (current_token(unit) != NULL && current_token(unit)->type != TOKEN_EOFT) {
+        /*printf("Debug: Processing token of type %d at index %d\n", current_token(unit)->type, current_token(unit)->index);*/
 
-        if (unit->tokens->token.type == TOKEN_EOL) {
-            unit->tokens = unit->tokens->next; /* Skip empty lines */
-        } else if (unit->tokens->token.type == TOKEN_EXTERN_INS) {
+        if (current_token(unit)->type == TOKEN_EOL) {
+            advance_token(unit); /* Skip empty lines */
+        } else if (current_token(unit)->type == TOKEN_EXTERN_INS) {
             /* Parse external directive */
-            ExternalNodeList *new_node = malloc(sizeof(ExternalNodeList));
-            if (new_node == NULL) {
-                fprintf(stderr, "Memory allocation failed in parse_translation_unit\n");
-                /*Consider adding proper error handling and cleanup here*/
-                return;
-            }
+            ExternalNodeList *new_node = arena_allocate(&unit->arena, sizeof(ExternalNodeList));
             new_node->next = NULL;
             new_node->external_node = parser_parse_external(unit);
             *external_node_list_last = new_node;
             external_node_list_last = &new_node->next;
-        } else if (unit->tokens->token.type == TOKEN_ENTRY_INS) {
+        } else if (current_token(unit)->type == TOKEN_ENTRY_INS) {
             /* Parse entry directive */
-            EntryNodeList *newNode = malloc(sizeof(EntryNodeList));
-            if (newNode == NULL) {
-                fprintf(stderr, "Memory allocation failed in parse_translation_unit\n");
-                /* Consider adding proper error handling and cleanup here */
-                return;
-            }
+            EntryNodeList *newNode = arena_allocate(&unit->arena, sizeof(EntryNodeList));
             newNode->next = NULL;
             newNode->entry_node = parser_parse_entry(unit);
             *entry_node_list_last = newNode;
             entry_node_list_last = &newNode->next;
-        } else if (unit->tokens->token.type == TOKEN_IDENTIFIER ||
-                   unit->tokens->token.type == TOKEN_DATA_INS ||
-                   unit->tokens->token.type == TOKEN_STRING_INS) {
+        } else if (current_token(unit)->type == TOKEN_IDENTIFIER ||
+                   current_token(unit)->type == TOKEN_DATA_INS ||
+                   current_token(unit)->type == TOKEN_STRING_INS) {
             /* Parse labeled statement (instruction or guidance) */
             label = parse_labeled_statement(unit);
             was_label_found = true;
-        } else if (unit->tokens->token.type == TOKEN_MACR ||
-                   unit->tokens->token.type == TOKEN_ENDMACR) {
-            /*printf("Debug: Encountered macro-related token '%s'. Skipping...\n", unit->tokens->token.string.data);*/
+        } else if (current_token(unit)->type == TOKEN_MACR ||
+                   current_token(unit)->type == TOKEN_ENDMACR) {
+            /*printf("Debug: Encountered macro-related token '%s'. Skipping...\n", current_token(unit)->string.data);*/
             /* Skip macro-related tokens if they somehow made it through preprocessing */
-            /* unit->tokens = unit->tokens->next;*/
+            /* advance_token(unit);*/
             parser_move_to_end_of_line(unit);
         } else {
             /*printf("Debug: Unexpected token encountered: type %d at index %d\n",
-                   unit->tokens->token.type, unit->tokens->token.index);*/
+                   current_token(unit)->type, current_token(unit)->index);*/
             /* Unexpected token */
             error.message = string_create_from_cstr("Unexpected token: expected label, .extern, or .entry");
-            error.token = unit->tokens->token;
+            error.token = *current_token(unit);
             error_handler_add_token_error(&unit->error_handler, PARSER_ERROR_TYPE, error);
             parser_move_to_end_of_line(unit);
         }
 
         /* Add the label to the corresponding list */
         if (was_label_found) {
-            LabelNodeList *newNode = malloc(sizeof(LabelNodeList));
-            if (newNode == NULL) {
-                fprintf(stderr, "Memory allocation failed in parse_translation_unit\n");
-                /* Consider adding proper error handling and cleanup here */
-                return;
-            }
+            LabelNodeList *newNode = arena_allocate(&unit->arena, sizeof(LabelNodeList));
             newNode->next = NULL;
             newNode->label = label;
 
-            if (label.instruction_list != NULL) {
+            if (label.instruction_count > 0) {
                 *instruction_label_list_last = newNode;
                 instruction_label_list_last = &newNode->next;
             } else if (label.guidance_list != NULL) {
@@ -728,35 +811,192 @@ void parse_translation_unit_content(TranslationUnit *unit) {
     /*printf("Debug: Finished parsing translation unit.\n");*/
 }
 
-
 /**
- * Add a token reference to the end of the token reference list
+ * The number of ranges parse_translation_unit_content parses the unit in, one per core for a large unit
+ * when built with -DPARSER_THREADS, 1 otherwise.
  *
- * @param list the reference to the token reference list.
- * @param token the token reference.
-*/
-static void append_token_to_list(TokenReferenceNode **list, Token *token) {
-    TokenReferenceNode *new_node;
-    new_node = safe_malloc(sizeof(TokenReferenceNode));
-
-    if (list == NULL || token == NULL)
-        return;
+ * @param unit the translation unit.
+ * @return the number of ranges.
+ */
+static unsigned int thread_range_count(TranslationUnit *unit) {
+#ifdef PARSER_THREADS
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned long range_count = unit->tokens.count / MIN_RANGE_TOKENS;
+
+    if (processors > 0 && range_count > (unsigned long)processors)
+        range_count = processors;
+    if (range_count > MAX_PARSER_THREADS)
+        range_count = MAX_PARSER_THREADS;
+    return range_count > 1 ? (unsigned int)range_count : 1;
+#else
+    (void) unit;
+    return 1;
+#endif
+}
 
+/**
+ * Whether a range may start at a token: the first token of a line that starts a new statement,
+ * when the line before it does not end with a label's colon (that label takes the next statement).
+ *
+ * @param unit the translation unit.
+ * @param index the token's index.
+ * @return true if the statements before the token never read it.
+ */
+static bool is_range_start(TranslationUnit *unit, unsigned int index) {
+    Token *tokens = unit->tokens.data;
+    unsigned int previous = index;
+
+    if (index == 0 || tokens[index - 1].type != TOKEN_EOL)
+        return false;
+    if (tokens[index].type != TOKEN_IDENTIFIER && tokens[index].type != TOKEN_EXTERN_INS &&
+        tokens[index].type != TOKEN_ENTRY_INS)
+        return false;
+
+    /* Empty lines are skipped after a colon, so the colon may be a few lines up */
+    while (previous > 0 && tokens[previous - 1].type == TOKEN_EOL) {
+        previous--;
+    }
+    return previous == 0 || tokens[previous - 1].type != TOKEN_COLON;
+}
 
-    new_node->token = token;
-    new_node->next = NULL;
+/**
+ * Cut the unit's tokens in up to range_count ranges of about the same size and set up a unit for each.
+ * Every range gets the rows of the parent's instruction table its instruction tokens can take.
+ *
+ * @param unit the translation unit.
+ * @param ranges the ranges to set up.
+ * @param range_count the number of ranges wanted.
+ * @return the number of ranges (a unit with few statements gets fewer).
+ */
+static unsigned int cut_ranges(TranslationUnit *unit, ParserRange *ranges, unsigned int range_count) {
+    unsigned int length = unit->tokens.count;
+    unsigned int starts[MAX_PARSER_THREADS + 1];
+    unsigned int count = 1;
+    unsigned int target;
+    unsigned int index;
+    unsigned int row = unit->instructions.count;
+    unsigned int rows;
+    TranslationUnit *range;
+    unsigned int i;
+
+    starts[0] = unit->current;
+    for (i = 1; i < range_count; i++) {
+        target = (unsigned int)((unsigned long)length * i / range_count);
+        if (target <= starts[count - 1])
+            target = starts[count - 1] + 1;
+        while (target < length && !is_range_start(unit, target)) {
+            target++;
+        }
+        if (target >= length)
+            break;
+        starts[count++] = target;
+    }
+    starts[count] = length;
 
-    if (*list == NULL) {
-        *list = new_node;
-    } else {
-        TokenReferenceNode *current = *list;
-        while (current->next != NULL) {
-            current = current->next;
+    for (i = 0; i < count; i++) {
+        rows = 0;
+        for (index = starts[i]; index < starts[i + 1]; index++) {
+            if (is_instruction_token(unit->tokens.data[index].type))
+                rows++;
         }
-        current->next = new_node;
+
+        range = &ranges[i].unit;
+        range->external_list = NULL;
+        range->entry_list = NULL;
+        range->instruction_label_list = NULL;
+        range->guidance_label_list = NULL;
+        range->tokens.data = unit->tokens.data;
+        range->tokens.count = starts[i + 1];
+        range->tokens.capacity = starts[i + 1];
+        range->current = starts[i];
+        arena_initialize(&range->arena, (starts[i + 1] - starts[i]) * ARENA_BYTES_PER_TOKEN > MIN_ARENA_SLAB_SIZE ?
+                                        (starts[i + 1] - starts[i]) * ARENA_BYTES_PER_TOKEN : MIN_ARENA_SLAB_SIZE);
+        error_handler_initialize(&range->error_handler, unit->error_handler.string, unit->error_handler.line_index,
+                                 unit->error_handler.file_path);
+
+        /* The range writes its rows right into the parent's arrays, they are moved up to the rows before on join */
+        range->instructions = unit->instructions;
+        range->instructions.opcode += row;
+        range->instructions.source_mode += row;
+        range->instructions.destination_mode += row;
+        range->instructions.flags += row;
+        range->instructions.source_value += row;
+        range->instructions.destination_value += row;
+        range->instructions.token += row;
+        range->instructions.source_token += row;
+        range->instructions.destination_token += row;
+        range->instructions.count = 0;
+        range->instructions.capacity = rows;
+
+        ranges[i].first_row = row;
+        row += rows;
+    }
+
+    return count;
+}
+
+/* Thread entry, parses one range (the signature is the one pthread_create takes) */
+static void *parse_range(void *range) {
+    parse_statements(&((ParserRange *) range)->unit);
+    return NULL;
+}
+
+/**
+ * Append a parsed range to the unit, which holds everything parsed before it.
+ * The range's label rows are counted from its own first row, they are moved to follow the unit's rows.
+ *
+ * @param unit the translation unit.
+ * @param range the parsed range.
+ */
+static void join_range(TranslationUnit *unit, ParserRange *range) {
+    InstructionTable *table = &unit->instructions;
+    unsigned int from = range->first_row;
+    unsigned int to = table->count;
+    unsigned int rows = range->unit.instructions.count;
+    ExternalNodeList **external_last = &unit->external_list;
+    EntryNodeList **entry_last = &unit->entry_list;
+    LabelNodeList **instruction_label_last = &unit->instruction_label_list;
+    LabelNodeList **guidance_label_last = &unit->guidance_label_list;
+    LabelNodeList *label;
+
+    if (from != to) {
+        memmove(table->opcode + to, table->opcode + from, rows * sizeof(unsigned char));
+        memmove(table->source_mode + to, table->source_mode + from, rows * sizeof(unsigned char));
+        memmove(table->destination_mode + to, table->destination_mode + from, rows * sizeof(unsigned char));
+        memmove(table->flags + to, table->flags + from, rows * sizeof(unsigned char));
+        memmove(table->source_value + to, table->source_value + from, rows * sizeof(int));
+        memmove(table->destination_value + to, table->destination_value + from, rows * sizeof(int));
+        memmove(table->token + to, table->token + from, rows * sizeof(unsigned int));
+        memmove(table->source_token + to, table->source_token + from, rows * sizeof(unsigned int));
+        memmove(table->destination_token + to, table->destination_token + from, rows * sizeof(unsigned int));
+    }
+    for (label = range->unit.instruction_label_list; label != NULL; label = label->next) {
+        label->label.first_instruction += to;
+    }
+    table->count += rows;
+
+    while (*external_last != NULL) {
+        external_last = &(*external_last)->next;
+    }
+    *external_last = range->unit.external_list;
+    while (*entry_last != NULL) {
+        entry_last = &(*entry_last)->next;
     }
+    *entry_last = range->unit.entry_list;
+    while (*instruction_label_last != NULL) {
+        instruction_label_last = &(*instruction_label_last)->next;
+    }
+    *instruction_label_last = range->unit.instruction_label_list;
+    while (*guidance_label_last != NULL) {
+        guidance_label_last = &(*guidance_label_last)->next;
+    }
+    *guidance_label_last = range->unit.guidance_label_list;
+
+    error_handler_take_errors(&unit->error_handler, &range->unit.error_handler);
+    arena_absorb(&unit->arena, &range->unit.arena);
 }
 
+
 /**
  * Parse instruction operand
  *
@@ -767,43 +1007,47 @@ static void append_token_to_list(TokenReferenceNode **list, Token *token) {
 
 static InstructionOperand parse_operand(TranslationUnit *unit, bool *error_occurred) {
     InstructionOperand operand = {NULL, false};
-    TokenNode *current;
+    Token *current;
+    Token *next;
     TokenType type;
 
     *error_occurred = true;
 
-    if (unit->tokens == NULL)
+    if (current_token(unit) == NULL)
         return operand;
 
-    current = unit->tokens;
-    type = current->token.type;
+    current = current_token(unit);
+    type = current->type;
 
     if (type == TOKEN_HASHTAG) {
         /* Handle immediate operand */
-        if (current->next == NULL || current->next->token.type != TOKEN_NUMBER) {
-            report_error(unit, "Expected number after '#'", &current->token);
+        next = peek_token(unit, 1);
+        if (next == NULL || next->type != TOKEN_NUMBER) {
+            report_error(unit, "Expected number after '#'", current);
             return operand;
         }
-        operand.operand = &current->next->token;
-        unit->tokens = current->next->next;
+        operand.operand = next;
+        advance_token(unit);
+        advance_token(unit);
         *error_occurred = false;
     } else {
         /* Handle register or identifier operand */
         if (type == TOKEN_STAR) {
             operand.is_dereferenced = true;
-            current = current->next;
+            current = peek_token(unit, 1);
             if (current == NULL) {
-                report_error(unit, "Expected operand after '*'", &unit->tokens->token);
+                report_error(unit, "Expected operand after '*'", current_token(unit));
                 return operand;
             }
+            advance_token(unit);
         }
 
-        if (current->token.type == TOKEN_REGISTER || current->token.type == TOKEN_IDENTIFIER) {
-            operand.operand = &current->token;
-            unit->tokens = current->next;
+        if (current->type == TOKEN_REGISTER || current->type == TOKEN_IDENTIFIER) {
+            operand.operand = current;
+            advance_token(unit);
             *error_occurred = false;
         } else {
-            report_error(unit, "Expected register or identifier", &current->token);
+            report_error(unit, "Expected register or identifier", current);
         }
     }
     return operand;
@@ -833,6 +1077,100 @@ static bool is_instruction_token(TokenType type) {
     }
 }
 
+/**
+ * Get the token at the parser cursor
+ *
+ * @param unit the translation unit.
+ * @return the current token, or NULL if the token array is exhausted.
+ */
+static Token *current_token(TranslationUnit *unit) {
+    return peek_token(unit, 0);
+}
+
+/**
+ * Look ahead of the parser cursor without moving it
+ *
+ * @param unit the translation unit.
+ * @param offset how many tokens past the cursor to look.
+ * @return the token at that position, or NULL if it is past the end of the token array.
+ */
+static Token *peek_token(TranslationUnit *unit, unsigned int offset) {
+    if (unit->current + offset >= unit->tokens.count)
+        return NULL;
+
+    return &unit->tokens.data[unit->current + offset];
+}
+
+/**
+ * Move the parser cursor to the next token, never past the EOF token
+ *
+ * @param unit the translation unit.
+ */
+static void advance_token(TranslationUnit *unit) {
+    if (unit->current < unit->tokens.count && unit->tokens.data[unit->current].type != TOKEN_EOFT)
+        unit->current++;
+}
+
+/**
+ * Size the unit's instruction table by its instruction tokens, which bound the rows it can get,
+ * so the arrays are taken from the arena once and never grow. The arena's first slab is sized here too:
+ * for every node of the unit, or only for the table when the unit is going to be parsed in ranges
+ * (their nodes are allocated in the ranges' own arenas).
+ *
+ * @param unit the translation unit.
+ */
+static void initialize_instruction_table(TranslationUnit *unit) {
+    InstructionTable *table = &unit->instructions;
+    unsigned int index;
+    unsigned int capacity = 0;
+    unsigned long slab_size;
+
+    for (index = 0; index < unit->tokens.count; index++) {
+        if (is_instruction_token(unit->tokens.data[index].type))
+            capacity++;
+    }
+
+    if (thread_range_count(unit) > 1)
+        slab_size = (unsigned long) capacity * INSTRUCTION_ROW_BYTES + INSTRUCTION_TABLE_PADDING;
+    else
+        slab_size = (unsigned long) unit->tokens.count * ARENA_BYTES_PER_TOKEN;
+    arena_initialize(&unit->arena, slab_size > MIN_ARENA_SLAB_SIZE ? slab_size : MIN_ARENA_SLAB_SIZE);
+
+    table->count = 0;
+    table->capacity = capacity;
+    if (capacity == 0)
+        capacity = 1; /* Keep the arrays valid pointers */
+
+    table->opcode = arena_allocate(&unit->arena, capacity * sizeof(unsigned char));
+    table->source_mode = arena_allocate(&unit->arena, capacity * sizeof(unsigned char));
+    table->destination_mode = arena_allocate(&unit->arena, capacity * sizeof(unsigned char));
+    table->flags = arena_allocate(&unit->arena, capacity * sizeof(unsigned char));
+    table->source_value = arena_allocate(&unit->arena, capacity * sizeof(int));
+    table->destination_value = arena_allocate(&unit->arena, capacity * sizeof(int));
+    table->token = arena_allocate(&unit->arena, capacity * sizeof(unsigned int));
+    table->source_token = arena_allocate(&unit->arena, capacity * sizeof(unsigned int));
+    table->destination_token = arena_allocate(&unit->arena, capacity * sizeof(unsigned int));
+}
+
+/**
+ * The addressing mode of an operand, from its token type and whether it is dereferenced.
+ * A dereferenced label stays direct, the semantic analyzer reports it from the row's flags.
+ *
+ * @param operand the operand token.
+ * @param is_dereferenced true if the operand was written after '*'.
+ * @return the operand's addressing mode.
+ */
+static AddressingMode operand_addressing_mode(Token *operand, bool is_dereferenced) {
+    switch (operand->type) {
+        case TOKEN_IDENTIFIER:
+            return ADDRESSING_MODE_DIRECT;
+        case TOKEN_REGISTER:
+            return is_dereferenced ? ADDRESSING_MODE_INDIRECT_REGISTER : ADDRESSING_MODE_DIRECT_REGISTER;
+        default:
+            return ADDRESSING_MODE_IMMEDIATE;
+    }
+}
+
 static void report_error(TranslationUnit *unit, const char *message, Token *token) {
     TokenError error;
     error.message = string_create_from_cstr(message);
@@ -1,44 +1,132 @@
+/* Precompiled macro library images are mapped in with POSIX mmap */
+#define _POSIX_C_SOURCE 200112L
+
 #include "../headers/safe_allocations.h"
 #include "../headers/preprocessor.h"
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #define RED_COLOR   "\x1B[1;91m"
 #define RESET_COLOR "\x1B[0m"
 
-static void write_string_to_file(FILE *file, String data);
+#define INITIAL_PIECE_CAPACITY 64
+#define INITIAL_EXPANSION_CAPACITY 64
+
+#define LIBRARY_IMAGE_EXTENSION ".amc"
+#define LIBRARY_IMAGE_MAGIC 0x414D4303UL /* "AMC" and the version of the layout */
+
+/* The start of a precompiled macro library image, its tokens, macros and hash index follow it in that order */
+typedef struct LibraryImageHeader {
+    unsigned long magic;        /* LIBRARY_IMAGE_MAGIC */
+    unsigned long content_hash; /* compute_string_hash of the library's text the image was built from */
+    unsigned int text_length;   /* Length of the library's text the image was built from */
+    unsigned int token_size;    /* sizeof(Token) of the build that wrote the image */
+    unsigned int macro_size;    /* sizeof(Macro) of the build that wrote the image */
+    unsigned int token_count;   /* Number of tokens */
+    unsigned int macro_count;   /* Number of macros */
+    unsigned int table_size;    /* Number of cells in the hash index */
+} LibraryImageHeader;
 
-void preprocessor_initialize(Preprocessor *preprocessor, Lexer lexer, char *file_path) {
+static void write_pieces_to_file(FILE *file, PieceTable table, String source);
+static void piece_table_append(PieceTable *table, unsigned int first, unsigned int start, unsigned int length);
+static void append_tokens(TokenArray *array, const Token *tokens, unsigned int count);
+static void reserve_tokens(TokenArray *array, unsigned int count);
+static MacroExpansion *expansion_of(Macro *macro, MacroLibrary *library);
+static MacroExpansion *expand_macro(Preprocessor *preprocessor, Macro *macro, MacroLibrary *library, String source);
+static void macro_table_insert(Preprocessor *preprocessor, MacroList *node);
+static void macro_table_grow(Preprocessor *preprocessor);
+static MacroList *skip_passed_definitions(MacroList *definition, unsigned int index);
+static void expand(Preprocessor *preprocessor, String source, bool collect_macros, bool render_text, bool replace_tokens);
+static Macro *find_macro(Preprocessor *preprocessor, Token identifier, String source, MacroLibrary **library);
+static bool map_library_image(MacroLibrary *library, unsigned int text_length, unsigned long content_hash);
+static bool build_library_image(MacroLibrary *library, Lexer *lexer, unsigned long content_hash);
+static void check_macro_only(Preprocessor *collector);
+static void attach_library_image(MacroLibrary *library);
+static unsigned long library_image_size(const LibraryImageHeader *header);
+static bool check_library_image(const MacroLibrary *library);
+static unsigned int append_library_text(Preprocessor *preprocessor, String text, const char *file_path);
+static char *resolve_library_path(const char *including_path, const char *text, unsigned int length);
+
+void preprocessor_initialize(Preprocessor *preprocessor, Lexer *lexer, char *file_path) {
     /* Allocate memory for the output file path (.am extension) */
-    char *curated_file_path = safe_calloc(strlen(file_path) + 4, sizeof(char));
-    sprintf(curated_file_path, "%s.am", file_path);
+    char *expanded_file_path = safe_calloc(strlen(file_path) + 4, sizeof(char));
+    sprintf(expanded_file_path, "%s.am", file_path);
 
     /* Initialize preprocessor fields */
     preprocessor->processed_source = string_create();
+    preprocessor->expanded_source.pieces = NULL;
+    preprocessor->expanded_source.count = 0;
+    preprocessor->expanded_source.capacity = 0;
     preprocessor->macro_list = NULL;
-    preprocessor->tokens = lexer.token_list;
+    preprocessor->macro_list_tail = NULL;
+    preprocessor->macro_count = 0;
+    /* The lexer counted the macr tokens, so the table is sized once with a load factor of 0.75 */
+    preprocessor->macro_table_size = (unsigned int) (lexer->macro_count / 0.75) + 1;
+    preprocessor->macro_table = safe_calloc(preprocessor->macro_table_size, sizeof(MacroList *));
+    preprocessor->lexer = lexer;
+    preprocessor->source_code = lexer->source_code;
+    preprocessor->tokens = lexer->tokens;
+    preprocessor->current = 0;
+    preprocessor->write_expanded_file = true;
+    preprocessor->expanded_file_path = expanded_file_path;
+    preprocessor->libraries = NULL;
+    preprocessor->library_count = 0;
+    preprocessor->file_length = lexer->source_code.length;
+    preprocessor->expansion_tokens.data = NULL;
+    preprocessor->expansion_tokens.count = 0;
+    preprocessor->expansion_tokens.capacity = 0;
+    preprocessor->expansion_pieces.pieces = NULL;
+    preprocessor->expansion_pieces.count = 0;
+    preprocessor->expansion_pieces.capacity = 0;
 
-    /* Initialize the error handler */
-    error_handler_initialize(&preprocessor->error_handler, lexer.source_code, curated_file_path);
+    /* Initialize the error handler, errors point into the lexer's source so they name its file (the .am may never be written) */
+    error_handler_initialize(&preprocessor->error_handler, lexer->source_code, &lexer->line_index, lexer->file_path);
 }
 
 void preprocessor_free(Preprocessor *preprocessor) {
     MacroList *current = preprocessor->macro_list;
     MacroList *temp;
+    MacroLibrary *library;
+    unsigned int i;
 
     /* Free the processed source string */
     string_free(preprocessor->processed_source);
+    free(preprocessor->expanded_source.pieces);
+    free(preprocessor->expansion_tokens.data);
+    free(preprocessor->expansion_pieces.pieces);
     /* Free the error handler */
     error_handler_free(&preprocessor->error_handler);
 
+    /* Free the hash table (its cells point into the list) */
+    free(preprocessor->macro_table);
+    preprocessor->macro_table = NULL;
+
+    /* Release the library images, a mapped one is unmapped */
+    for (i = 0; i < preprocessor->library_count; i++) {
+        library = &preprocessor->libraries[i];
+        if (library->mapped)
+            munmap(library->image, library->image_size);
+        else
+            free(library->image);
+        free(library->expansions);
+        free(library->path);
+    }
+    free(preprocessor->libraries);
+    preprocessor->libraries = NULL;
+    preprocessor->library_count = 0;
+
     /* Free all macros in the list */
     while (current != NULL) {
-        string_free(current->macro.content);
         temp = current;
         current = current->next;
         free(temp);
     }
 
-    /* Free the file path */
-    free(preprocessor->error_handler.file_path);
+    /* Free the output file path */
+    free(preprocessor->expanded_file_path);
 }
 
 void preprocessor_create_macro(Preprocessor * preprocessor, String source){
@@ -46,79 +134,78 @@ void preprocessor_create_macro(Preprocessor * preprocessor, String source){
     TokenError error;
     int content_start, content_end;
     bool valid_end_macro = false;
-    TokenNode *current_token;
-    MacroList *existing;
+    Token *tokens;
+    unsigned int current;
 
-    current_token = preprocessor->tokens;
+    tokens = preprocessor->tokens.data;
+    current = preprocessor->current;
     /*printf("Debug: Attempting to create a macro...\n");*/
 
     /* Check if the current token is a MACR token */
-    if (current_token->token.type != TOKEN_MACR) {
+    if (tokens[current].type != TOKEN_MACR) {
         error.message = string_create_from_cstr("Expected MACR token");
-        error.token = current_token->token;
+        error.token = tokens[current];
         error_handler_add_token_error(&preprocessor->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
         return;
     }
-    /*printf("Debug: Found MACR token at index %d\n", current_token->token.index);*/
+    /*printf("Debug: Found MACR token at index %d\n", tokens[current].index);*/
 
     /* Store the start index of the macro */
-    macro.start_index = current_token->token.index;
-    current_token = current_token->next;
+    macro.start_index = tokens[current].index;
+    current++;
 
     /* Check for and store the macro identifier */
-    if (current_token->token.type != TOKEN_IDENTIFIER) {
+    if (tokens[current].type != TOKEN_IDENTIFIER) {
         error.message = string_create_from_cstr("Expected identifier after MACR");
-        error.token = current_token->token;
+        error.token = tokens[current];
         error_handler_add_token_error(&preprocessor->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
-        /*printf("Debug: Macro identifier found: %s\n", current_token->token.string.data);*/
+        /*printf("Debug: Macro identifier found: %s\n", tokens[current].string.data);*/
         return;
     }
 
-    macro.identifier = current_token->token;
+    macro.identifier = tokens[current];
 
     /* Check for duplicate macro names */
-    existing = preprocessor->macro_list;
-    while (existing != NULL) {
-        if (string_equals(macro.identifier.string, existing->macro.identifier.string)) {
-            error.message = string_create_from_cstr("Duplicate macro identifier");
-            error.token = macro.identifier;
-            error_handler_add_token_error(&preprocessor->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
-            return;
-        }
-        existing = existing->next;
+    if (preprocessor_find_macro(preprocessor, macro.identifier, source) != NULL) {
+        error.message = string_create_from_cstr("Duplicate macro identifier");
+        error.token = macro.identifier;
+        error_handler_add_token_error(&preprocessor->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
+        return;
     }
 
-    current_token = current_token->next;
+    current++;
 
     /* Ensure newline after macro identifier */
-    if (current_token->token.type != TOKEN_EOL) {
+    if (tokens[current].type != TOKEN_EOL) {
         error.message = string_create_from_cstr("Expected newline after macro identifier");
-        error.token = current_token->token;
+        error.token = tokens[current];
         error_handler_add_token_error(&preprocessor->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
         return;
     }
 
     /* Mark the start of macro content */
-    content_start = current_token->token.index + 1;
-    current_token = current_token->next;
+    content_start = tokens[current].index + 1;
+    current++;
+    macro.body_start = current;
 
     /* Find the end of the macro */
-    while (current_token != NULL && current_token->next != NULL && current_token->next->next != NULL) {
-        if (current_token->token.type == TOKEN_EOL &&
-            current_token->next->token.type == TOKEN_ENDMACR &&
-            (current_token->next->next->token.type == TOKEN_EOL || current_token->next->next->token.type == TOKEN_EOFT)) {
-            content_end = current_token->token.index;
-            macro.end_index = current_token->next->next->token.index;
+    while (current + 2 < preprocessor->tokens.count) {
+        if (tokens[current].type == TOKEN_EOL &&
+            tokens[current + 1].type == TOKEN_ENDMACR &&
+            (tokens[current + 2].type == TOKEN_EOL || tokens[current + 2].type == TOKEN_EOFT)) {
+            content_end = tokens[current].index;
+            macro.end_index = tokens[current + 2].index;
+            macro.body_end = current + 1;
             valid_end_macro = true;
             break;
         }
-        current_token = current_token->next;
+        current++;
     }
 
     /* Check if the macro end was found */
     if (!valid_end_macro) {
         error.message = string_create_from_cstr("Invalid or missing ENDMACR");
-        error.token = preprocessor->tokens->token;
+        error.token = tokens[preprocessor->current];
         error_handler_add_token_error(&preprocessor->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
         /*printf("Debug: ENDMACR token was not found\n");*/
         return;
@@ -126,39 +213,51 @@ void preprocessor_create_macro(Preprocessor * preprocessor, String source){
     /*printf("Debug: Macro '%s' created successfully with content:\n%s\n",
        macro.identifier.string.data, macro.content.data);*/
 
-    /* Extract macro content */
-    macro.content = string_substring(source, content_start, content_end);
+    /* The content is the source range up to the newline before endmacr (the body tokens are already lexed) */
+    macro.content_start = content_start;
+    macro.content_length = content_end - content_start + 1;
     preprocessor_append_macro(preprocessor, macro);
 }
 
 void preprocessor_generate_macro_list(Preprocessor *preprocessor, String source) {
-    TokenNode *current = preprocessor->tokens;
-    while (current != NULL && current->token.type != TOKEN_EOFT) {
-        if (current->token.type == TOKEN_MACR) {
-            preprocessor->tokens = current;  /* Set the current token for macro generation */
+    unsigned int current;
+
+    for (current = 0; current < preprocessor->tokens.count && preprocessor->tokens.data[current].type != TOKEN_EOFT; current++) {
+        if (preprocessor->tokens.data[current].type == TOKEN_MACR) {
+            preprocessor->current = current;  /* Set the current token for macro generation */
             preprocessor_create_macro(preprocessor, source);
         }
-        current = current->next;
     }
-    preprocessor->tokens = current;  /* Reset to the original token list */
+    preprocessor->current = 0;  /* Reset to the start of the token array */
+}
+
+Macro *preprocessor_find_macro(Preprocessor * preprocessor, Token identifier, String source){
+    MacroLibrary *library;
+
+    return find_macro(preprocessor, identifier, source, &library);
 }
 
 void preprocessor_append_macro(Preprocessor * preprocessor, Macro macro){
     /* Create a new macro node */
     MacroList *new_macro = safe_malloc(sizeof(MacroList));
     new_macro->macro = macro;
+    new_macro->expansion.state = EXPANSION_PENDING;
     new_macro->next = NULL;
 
     /* Append the new macro to the list */
     if (preprocessor->macro_list == NULL) {
         preprocessor->macro_list = new_macro;
     } else {
-        MacroList *last = preprocessor->macro_list;
-        while (last->next != NULL) {
-            last = last->next;
-        }
-        last->next = new_macro;
+        preprocessor->macro_list_tail->next = new_macro;
     }
+    preprocessor->macro_list_tail = new_macro;
+
+    /* Index it by its identifier, keeping the load factor under 0.75 */
+    if ((preprocessor->macro_count + 1) / 0.75 >= preprocessor->macro_table_size) {
+        macro_table_grow(preprocessor);
+    }
+    macro_table_insert(preprocessor, new_macro);
+    preprocessor->macro_count++;
 }
 
 void preprocessor_display_macro_list(Preprocessor * preprocessor){
@@ -167,117 +266,897 @@ void preprocessor_display_macro_list(Preprocessor * preprocessor){
     current = preprocessor->macro_list;
     /* Iterate through the macro list and print each macro */
     while (current != NULL) {
-        printf("Macro identifier: %s\n", current->macro.identifier.string.data);
-        printf("Macro content:\n%s\n", current->macro.content.data);
+        printf("Macro identifier: %.*s\n", (int)current->macro.identifier.length,
+               token_text(current->macro.identifier, preprocessor->source_code));
+        printf("Macro content:\n%.*s\n", (int)current->macro.content_length,
+               preprocessor->source_code.data + current->macro.content_start);
         printf("End of macro\n\n");
         current = current->next;
     }
 }
 
 void preprocessor_expand_macros(Preprocessor * preprocessor, String source){
-    TokenNode *current_token;
     unsigned int i;
-    MacroList *macro;
-    bool is_macro;
+    SourcePiece piece;
 
-    current_token = preprocessor->tokens;
-    i = 0;
-    /*printf("Debug: Starting macro expansion...\n");*/
-
-    /* Process the source code character by character */
-    while (i < string_length(source)) {
-        if (current_token != NULL && i == current_token->token.index) {
-            /* Skip the entire macro definition */
-            is_macro = false;
-            macro = preprocessor->macro_list;
-            /* printf("Debug: Expanding or skipping token at index %d\n", i);*/
-            /* printf("Debug: Processing token '%s' at index %d\n", current_token->token.string.data, i);*/
-
-
-            while (macro != NULL) {
-                if (i >= macro->macro.start_index && i <= macro->macro.end_index) {
-                    /* Skip the entire macro definition */
-                    i = macro->macro.end_index + 1;
-                    while (current_token != NULL && current_token->token.index <= macro->macro.end_index) {
-                        current_token = current_token->next;
-                    }
-                    is_macro = true;
-                    /* printf("Debug: Skipping macro definition for '%s'\n", macro->macro.identifier.string.data);*/
+    expand(preprocessor, source, false, true, false);
 
-                    break;
-                }
-                if (string_equals(macro->macro.identifier.string, current_token->token.string)) {
-                    /* Expand the macro */
-                    string_append(&preprocessor->processed_source, macro->macro.content);
-                    i += string_length(current_token->token.string);
-                    current_token = current_token->next;
-                    /* Skip newline after macro expansion if present */
-                    if (current_token != NULL && current_token->token.type == TOKEN_EOL) {
-                        current_token = current_token->next;
-                        i++;
-                    }
-                    is_macro = true;
-                    /* printf("Debug: Expanding macro '%s' at index %d\n", macro->macro.identifier.string.data, i);*/
+    /* Flatten the pieces into one text */
+    for (i = 0; i < preprocessor->expanded_source.count; i++) {
+        piece = preprocessor->expanded_source.pieces[i];
+        string_append_chars(&preprocessor->processed_source, source.data + piece.start, piece.length);
+    }
+}
 
-                    break;
-                }
-                macro = macro->next;
-            }
+void preprocessor_expand_tokens(Preprocessor *preprocessor, String source) {
+    expand(preprocessor, source, false, false, true);
+}
 
-            /* If not a macro, append the token as is */
-            if (!is_macro) {
-                string_append(&preprocessor->processed_source, current_token->token.string);
-                i += string_length(current_token->token.string);
-                current_token = current_token->next;
-            }
-            /* Append non-token characters */
+void preprocessor_include_library(Preprocessor *preprocessor, unsigned int include) {
+    Token *tokens;
+    MacroLibrary library;
+    Lexer library_lexer;
+    TokenError error;
+    unsigned long content_hash;
+    unsigned int i;
+
+    tokens = preprocessor->tokens.data;
+
+    /* The include takes a line of its own: .include "path" */
+    if (tokens[include + 1].type != TOKEN_STRING ||
+        (tokens[include + 2].type != TOKEN_EOL && tokens[include + 2].type != TOKEN_EOFT)) {
+        error.message = string_create_from_cstr("Expected a quoted library path after .include");
+        error.token = tokens[include];
+        error_handler_add_token_error(&preprocessor->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
+        return;
+    }
+
+    /* The path is the string without its quotes, taken from the including file's directory */
+    library.path = resolve_library_path(preprocessor->lexer->file_path,
+                                        token_text(tokens[include + 1], preprocessor->source_code) + 1,
+                                        tokens[include + 1].length - 2);
+
+    /* A library included twice is loaded once */
+    for (i = 0; i < preprocessor->library_count; i++) {
+        if (strcmp(preprocessor->libraries[i].path, library.path) == 0) {
+            free(library.path);
+            return;
+        }
+    }
+
+    /* The library is read with the lexer's single sized read, and only lexed when the image does not match it */
+    if (lexer_initialize_from_file(&library_lexer, library.path)) {
+        content_hash = compute_string_hash(library_lexer.source_code.data, library_lexer.source_code.length - 1);
+        if (map_library_image(&library, library_lexer.source_code.length - 1, content_hash) ||
+            build_library_image(&library, &library_lexer, content_hash)) {
+            library.base = append_library_text(preprocessor, library_lexer.source_code, library_lexer.file_path);
+            library.expansions = safe_calloc(library.macro_count + 1, sizeof(MacroExpansion)); /* All pending */
+
+            preprocessor->libraries = safe_realloc(preprocessor->libraries,
+                                                   (preprocessor->library_count + 1) * sizeof(MacroLibrary));
+            preprocessor->libraries[preprocessor->library_count++] = library;
         } else {
-            string_append_char(&preprocessor->processed_source, string_char_at(source, i));
-            i++;
+            error.message = string_create_from_cstr("Macro library has errors");
+            error.token = tokens[include + 1];
+            error_handler_add_token_error(&preprocessor->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
+            free(library.path);
         }
+    } else {
+        error.message = string_create_from_cstr("Couldn't open macro library");
+        error.token = tokens[include + 1];
+        error_handler_add_token_error(&preprocessor->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
+        free(library.path);
     }
-    /* printf("Debug: Macro expansion completed. Processed source:\n%s\n", preprocessor->processed_source.data);*/
 
+    error_handler_free(&library_lexer.error_handler);
+    lexer_free(&library_lexer);
 }
 
 void preprocessor_process(Preprocessor *preprocessor, String source) {
     FILE *file;
-    /* Create the list of macros */
-    preprocessor_generate_macro_list(preprocessor, source);
+    Token *tokens;
+    unsigned int i;
+    bool in_definition;
+
+    /* Libraries are loaded first, so their macros are known at the first call. An include inside a macro body is
+     * left to the parser, like any other line of a body */
+    if (preprocessor->lexer->include_count > 0) {
+        tokens = preprocessor->tokens.data;
+        in_definition = false;
+        for (i = 0; i < preprocessor->tokens.count; i++) {
+            if (tokens[i].type == TOKEN_MACR)
+                in_definition = true;
+            else if (tokens[i].type == TOKEN_ENDMACR)
+                in_definition = false;
+            else if (tokens[i].type == TOKEN_INCLUDE_INS && !in_definition)
+                preprocessor_include_library(preprocessor, i);
+        }
+        /* The source grew by the libraries' text and may have moved */
+        source = preprocessor->source_code;
+    }
+
+    /* Record the macros as they are defined and expand them in the same walk (a macro is defined before its calls) */
+    expand(preprocessor, source, true, preprocessor->write_expanded_file, true);
 
-    /* If there are errors, stop processing */
+    /* If there are errors, stop processing (the lexer keeps its original tokens and no .am is written) */
     if (preprocessor->error_handler.error_list != NULL) return;
 
-    /* Expand macros in the source code */
-    preprocessor_expand_macros(preprocessor, source);
+    if (preprocessor->write_expanded_file) {
+        /* Open the output file */
+        file = fopen(preprocessor->expanded_file_path, "w");
+        if (file != NULL) {
+            /* Write the processed source to the file */
+            write_pieces_to_file(file, preprocessor->expanded_source, source);
+            fclose(file);
+        }
+    }
+}
 
-    /* Open the output file */
-    file = fopen(preprocessor->error_handler.file_path, "w");
-    if (file == NULL) {
-        /*printf("%sPreprocessor Error:%s Couldn't open \"%s\".\n", RED_COLOR, RESET_COLOR, preprocessor->error_handler.file_path);*/
+/**
+ * Walks the token stream once, dropping macro definitions and replacing every macro call by its body.
+ * Everything between two of these spots is copied in bulk, the source text with one append and the tokens with one
+ * memcpy, so only definitions and calls cost any work of their own.
+ *
+ * @param preprocessor Pointer to the Preprocessor.
+ * @param source The original source code as a String.
+ * @param collect_macros Define the macros as their macr token is met (otherwise the macro list must be complete).
+ * @param render_text Build the expanded source as pieces into expanded_source (for the .am file).
+ * @param replace_tokens Replace the lexer's token array by the expanded one (unless a macro definition had errors).
+ */
+static void expand(Preprocessor *preprocessor, String source, bool collect_macros, bool render_text, bool replace_tokens) {
+    TokenArray expanded;
+    Token *tokens;
+    unsigned int count;
+    unsigned int i;
+    unsigned int run_start; /* First token not copied yet */
+    unsigned int text_start; /* First source char not copied yet */
+    unsigned int skip_end; /* One past the last token of a definition or call */
+    unsigned int text_end; /* One past the last source char of a definition or call */
+    unsigned int j;
+    MacroList *definition;
+    Macro *macro;
+    MacroLibrary *library;
+    MacroExpansion *expansion;
+    SourcePiece piece;
+    unsigned int call; /* Number of the call being spliced in */
+
+    tokens = preprocessor->tokens.data;
+    count = preprocessor->tokens.count;
+    definition = preprocessor->macro_list;
+
+    /* The expanded stream is usually about as long as the original one */
+    expanded.count = 0;
+    expanded.capacity = count + 1;
+    expanded.data = safe_malloc(expanded.capacity * sizeof(Token));
+
+    run_start = 0;
+    text_start = 0;
+    i = 0;
+    while (i < count) {
+        macro = NULL;
+        if (collect_macros && tokens[i].type == TOKEN_MACR) {
+            preprocessor->current = i;
+            preprocessor_create_macro(preprocessor, source);
+            /* A definition with errors is reported and left in place, the expansion is thrown away anyway */
+            if (preprocessor->macro_list_tail != NULL && preprocessor->macro_list_tail->macro.start_index == (int) tokens[i].index) {
+                definition = preprocessor->macro_list_tail;
+            }
+        }
+
+        definition = skip_passed_definitions(definition, tokens[i].index);
+        if (definition != NULL && tokens[i].index >= (unsigned int) definition->macro.start_index) {
+            /* The definition runs to the token after endmacr, which is the only one with its end index */
+            skip_end = definition->macro.body_end + 2;
+            text_end = definition->macro.end_index + 1;
+
+            /* A macr inside the body defines a macro too (up to the same endmacr), as a separate scan would */
+            if (collect_macros && definition->macro.start_index == (int) tokens[i].index) {
+                for (j = i + 1; j < skip_end; j++) {
+                    if (tokens[j].type == TOKEN_MACR) {
+                        preprocessor->current = j;
+                        preprocessor_create_macro(preprocessor, source);
+                    }
+                }
+            }
+        } else if (tokens[i].type == TOKEN_INCLUDE_INS) {
+            /* The include line is dropped, its library was loaded before the walk */
+            skip_end = i + 1;
+            while (skip_end < count && tokens[skip_end].type != TOKEN_EOL && tokens[skip_end].type != TOKEN_EOFT) {
+                skip_end++;
+            }
+            if (skip_end < count && tokens[skip_end].type == TOKEN_EOL) {
+                text_end = tokens[skip_end].index + 1;
+                skip_end++;
+            } else {
+                text_end = (skip_end < count) ? tokens[skip_end].index : preprocessor->file_length;
+            }
+        } else if (tokens[i].type == TOKEN_IDENTIFIER && (macro = find_macro(preprocessor, tokens[i], source, &library)) != NULL) {
+            /* Skip newline after macro expansion if present (the body brings its own) */
+            skip_end = i + 1;
+            text_end = tokens[i].index + tokens[i].length;
+            if (skip_end < count && tokens[skip_end].type == TOKEN_EOL) {
+                skip_end++;
+                text_end++;
+            }
+        } else {
+            i++;
+            continue;
+        }
+
+        /* Copy everything before the definition or call, then the call's body */
+        append_tokens(&expanded, tokens + run_start, i - run_start);
+        if (render_text)
+            piece_table_append(&preprocessor->expanded_source, 0, text_start, tokens[i].index - text_start);
+        if (macro != NULL) {
+            /* The expansion is worked out at the first call, every call copies it */
+            expansion = expand_macro(preprocessor, macro, library, source);
+            append_tokens(&expanded, preprocessor->expansion_tokens.data + expansion->token_start, expansion->token_count);
+            if (replace_tokens) {
+                /* The spliced tokens keep their place in the definition and carry the call, a diagnostic names both */
+                call = line_index_add_call(&preprocessor->lexer->line_index, tokens[i]);
+                for (j = expanded.count - expansion->token_count; j < expanded.count; j++) {
+                    expanded.data[j].expansion = call;
+                }
+            }
+            if (render_text) {
+                for (j = 0; j < expansion->piece_count; j++) {
+                    piece = preprocessor->expansion_pieces.pieces[expansion->piece_start + j];
+                    piece_table_append(&preprocessor->expanded_source, 0, piece.start, piece.length);
+                }
+            }
+        }
+
+        i = skip_end;
+        run_start = skip_end;
+        text_start = text_end;
+    }
+
+    append_tokens(&expanded, tokens + run_start, count - run_start);
+    if (render_text && text_start < preprocessor->file_length)
+        piece_table_append(&preprocessor->expanded_source, 0, text_start, preprocessor->file_length - text_start);
+
+    /* A definition that runs to the end of the file takes the EOF token with it */
+    if (expanded.count == 0 || expanded.data[expanded.count - 1].type != TOKEN_EOFT) {
+        Token eof = tokens[count - 1];
+        eof.type = TOKEN_EOFT;
+        eof.index = preprocessor->file_length - 1;
+        eof.length = 0;
+        eof.value = 0;
+        eof.is_overflow = 0;
+        eof.expansion = 0;
+        append_tokens(&expanded, &eof, 1);
+    }
+
+    if (!replace_tokens || (collect_macros && preprocessor->error_handler.error_list != NULL)) {
+        free(expanded.data);
         return;
     }
 
-    /* Write the processed source to the file */
-    write_string_to_file(file, preprocessor->processed_source);
-    fclose(file);
+    /* The lexer now holds the expanded stream */
+    free(preprocessor->lexer->tokens.data);
+    preprocessor->lexer->tokens = expanded;
+    preprocessor->tokens = expanded;
+}
 
-    /* Update the error handler with the processed source */
-    preprocessor->error_handler.string = preprocessor->processed_source;
+/**
+ * Works out a macro's expansion, its body with every call of another macro replaced by that macro's expansion,
+ * unless it was worked out already. The inner macros are expanded first, so the macro's own run is appended to
+ * the expansion pool in one go after theirs. A call that leads back to a macro still being expanded is a cycle,
+ * it is reported and left as written.
+ *
+ * @param preprocessor Pointer to the Preprocessor.
+ * @param macro The macro to expand.
+ * @param library The library the macro comes from, NULL for a macro of the file itself.
+ * @param source The source code as a String (with the libraries' text).
+ * @return The macro's expansion.
+ */
+static MacroExpansion *expand_macro(Preprocessor *preprocessor, Macro *macro, MacroLibrary *library, String source) {
+    MacroExpansion *expansion;
+    MacroExpansion *inner_expansion;
+    Macro *inner;
+    MacroLibrary *inner_library;
+    TokenArray *pool;
+    PieceTable *pieces;
+    const Token *body; /* The token array the body lives in (the file's or its library's) */
+    Token call;
+    TokenError error;
+    unsigned int shift; /* How far the body's tokens are moved, the library's base or 0 */
+    unsigned int content_end;
+    unsigned int run_start; /* First body token not copied yet */
+    unsigned int text_start; /* First source char not copied yet */
+    unsigned int i;
+    unsigned int j;
+
+    expansion = expansion_of(macro, library);
+    if (expansion->state == EXPANSION_DONE)
+        return expansion;
+    expansion->state = EXPANSION_IN_PROGRESS;
+
+    body = (library != NULL) ? library->tokens : preprocessor->tokens.data;
+    shift = (library != NULL) ? library->base : 0;
+
+    /* Expand the inner macros first, a deep hierarchy is walked once since every expansion is kept */
+    for (i = macro->body_start; i < macro->body_end; i++) {
+        if (body[i].type != TOKEN_IDENTIFIER)
+            continue;
+        call = body[i];
+        call.index += shift;
+        inner = find_macro(preprocessor, call, source, &inner_library);
+        if (inner == NULL)
+            continue;
+        if (expansion_of(inner, inner_library)->state == EXPANSION_IN_PROGRESS) {
+            error.message = string_create_from_cstr("Macro call leads back to the macro being expanded");
+            error.token = call;
+            error_handler_add_token_error(&preprocessor->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
+        } else {
+            expand_macro(preprocessor, inner, inner_library, source);
+        }
+    }
+
+    /* Copy the body, replacing every expanded call the way expand does at the top level */
+    pool = &preprocessor->expansion_tokens;
+    pieces = &preprocessor->expansion_pieces;
+    expansion->token_start = pool->count;
+    expansion->piece_start = pieces->count;
+    content_end = shift + macro->content_start + macro->content_length;
+    run_start = macro->body_start;
+    text_start = shift + macro->content_start;
+    for (i = macro->body_start; i < macro->body_end; i++) {
+        if (body[i].type != TOKEN_IDENTIFIER)
+            continue;
+        call = body[i];
+        call.index += shift;
+        inner = find_macro(preprocessor, call, source, &inner_library);
+        if (inner == NULL)
+            continue;
+        inner_expansion = expansion_of(inner, inner_library);
+        if (inner_expansion->state != EXPANSION_DONE)
+            continue; /* A cycle, already reported */
+
+        j = pool->count;
+        append_tokens(pool, body + run_start, i - run_start);
+        for (; j < pool->count; j++) {
+            pool->data[j].index += shift;
+        }
+        piece_table_append(pieces, expansion->piece_start, text_start, call.index - text_start);
+
+        /* The inner run is in the same pool, so it is copied once the pool has made room */
+        reserve_tokens(pool, inner_expansion->token_count);
+        memcpy(pool->data + pool->count, pool->data + inner_expansion->token_start,
+               inner_expansion->token_count * sizeof(Token));
+        pool->count += inner_expansion->token_count;
+        for (j = 0; j < inner_expansion->piece_count; j++) {
+            piece_table_append(pieces, expansion->piece_start,
+                               pieces->pieces[inner_expansion->piece_start + j].start,
+                               pieces->pieces[inner_expansion->piece_start + j].length);
+        }
+
+        /* Skip newline after the call if present (the inner body brings its own) */
+        run_start = i + 1;
+        text_start = call.index + call.length;
+        if (run_start < macro->body_end && body[run_start].type == TOKEN_EOL) {
+            run_start++;
+            text_start++;
+        }
+        i = run_start - 1;
+    }
+
+    j = pool->count;
+    append_tokens(pool, body + run_start, macro->body_end - run_start);
+    for (; j < pool->count; j++) {
+        pool->data[j].index += shift;
+    }
+    if (text_start < content_end)
+        piece_table_append(pieces, expansion->piece_start, text_start, content_end - text_start);
+
+    expansion->token_count = pool->count - expansion->token_start;
+    expansion->piece_count = pieces->count - expansion->piece_start;
+    expansion->state = EXPANSION_DONE;
+    return expansion;
 }
 
 /**
- * Writes the given string data to a file.
+ * Finds where a macro's expansion is kept, next to the macro in its node or in its library's array.
+ *
+ * @param macro The macro.
+ * @param library The library the macro comes from, NULL for a macro of the file itself.
+ * @return The macro's expansion.
+ */
+static MacroExpansion *expansion_of(Macro *macro, MacroLibrary *library) {
+    if (library != NULL)
+        return &library->expansions[macro - library->macros];
+    return &((MacroList *) macro)->expansion; /* The macro is the first member of its node */
+}
+
+/**
+ * Writes the text of every piece to a file, up to the EOF sentinel.
  *
  * @param file The file to write to.
- * @param data The string data to write.
+ * @param table The pieces of the expanded source.
+ * @param source The original source code the pieces refer to.
+ */
+static void write_pieces_to_file(FILE *file, PieceTable table, String source) {
+    unsigned int i;
+    const char *start;
+    const char *end;
+
+    for (i = 0; i < table.count; i++) {
+        start = source.data + table.pieces[i].start;
+        /* The text is written up to the EOF sentinel, which only the last piece holds */
+        end = memchr(start, (char) EOF, table.pieces[i].length);
+        if (end != NULL) {
+            fwrite(start, 1, end - start, file);
+            return;
+        }
+        fwrite(start, 1, table.pieces[i].length, file);
+    }
+}
+
+/**
+ * Appends a run of the source to a piece table, extending the last piece when the run follows it directly.
+ *
+ * @param table The piece table to append to.
+ * @param first The index of the first piece that may be extended (the pieces before it belong to another run).
+ * @param start The index of the run's first char in the source.
+ * @param length The number of chars in the run.
  */
-static void write_string_to_file(FILE *file, String data) {
-    int i;
-    /* Write each character of the string to the file */
-    for (i = 0; i < string_length(data); i++) {
-        char c = string_char_at(data, i);
-        if (c == EOF || c == '\0') break;
-        fputc(c, file);
+static void piece_table_append(PieceTable *table, unsigned int first, unsigned int start, unsigned int length) {
+    SourcePiece *last;
+
+    if (length == 0) return;
+
+    if (table->count > first) {
+        last = &table->pieces[table->count - 1];
+        if (last->start + last->length == start) {
+            last->length += length;
+            return;
+        }
     }
+
+    /* Grow geometrically so appending stays amortized O(1) */
+    if (table->count == table->capacity) {
+        table->capacity = (table->capacity == 0) ? INITIAL_PIECE_CAPACITY : table->capacity * 2;
+        table->pieces = safe_realloc(table->pieces, table->capacity * sizeof(SourcePiece));
+    }
+    table->pieces[table->count].start = start;
+    table->pieces[table->count].length = length;
+    table->count++;
+}
+
+/**
+ * Appends a run of tokens to a token array, growing it geometrically when needed.
+ *
+ * @param array The array to append to.
+ * @param tokens The first token to append.
+ * @param count The number of tokens to append.
+ */
+static void append_tokens(TokenArray *array, const Token *tokens, unsigned int count) {
+    reserve_tokens(array, count);
+    memcpy(array->data + array->count, tokens, count * sizeof(Token));
+    array->count += count;
+}
+
+/**
+ * Makes room for more tokens at the end of a token array, growing it geometrically when needed.
+ * The array may move, pointers into it must be taken again afterwards.
+ *
+ * @param array The array to grow.
+ * @param count The number of tokens that will be appended.
+ */
+static void reserve_tokens(TokenArray *array, unsigned int count) {
+    if (array->count + count > array->capacity) {
+        while (array->count + count > array->capacity) {
+            array->capacity = (array->capacity == 0) ? INITIAL_EXPANSION_CAPACITY : array->capacity * 2;
+        }
+        array->data = safe_realloc(array->data, array->capacity * sizeof(Token));
+    }
+}
+
+/**
+ * Puts a macro node in the first empty cell of its probe sequence.
+ *
+ * @param preprocessor The preprocessor whose table takes the node.
+ * @param node The macro node to index.
+ */
+static void macro_table_insert(Preprocessor *preprocessor, MacroList *node) {
+    unsigned long index;
+
+    index = compute_string_hash(token_text(node->macro.identifier, preprocessor->source_code), node->macro.identifier.length)
+            % preprocessor->macro_table_size;
+    while (preprocessor->macro_table[index] != NULL) {
+        index = (index + 1) % preprocessor->macro_table_size; /* Move to next cell, wrap around if necessary */
+    }
+    preprocessor->macro_table[index] = node;
+}
+
+/**
+ * Doubles the hash table and indexes every macro of the list again.
+ * Only needed when more macros are appended than the lexer counted macr tokens.
+ *
+ * @param preprocessor The preprocessor whose table grows.
+ */
+static void macro_table_grow(Preprocessor *preprocessor) {
+    MacroList *node;
+
+    free(preprocessor->macro_table);
+    preprocessor->macro_table_size = preprocessor->macro_table_size * 2 + 1;
+    preprocessor->macro_table = safe_calloc(preprocessor->macro_table_size, sizeof(MacroList *));
+
+    for (node = preprocessor->macro_list; node != NULL && node != preprocessor->macro_list_tail; node = node->next) {
+        macro_table_insert(preprocessor, node);
+    }
+}
+
+/**
+ * Moves along the macro list (the definitions in source order) past every definition that ends before an index.
+ * Expansion walks the source forward, so every definition is passed once over the whole walk.
+ *
+ * @param definition The first definition that did not end before the previous index.
+ * @param index The source index being expanded.
+ * @return The first definition that does not end before index, NULL if there is none.
+ */
+static MacroList *skip_passed_definitions(MacroList *definition, unsigned int index) {
+    while (definition != NULL && (unsigned int) definition->macro.end_index < index) {
+        definition = definition->next;
+    }
+    return definition;
+}
+
+/**
+ * Looks up a macro by its identifier, in the file's own macros and then in every included library.
+ *
+ * @param preprocessor The preprocessor.
+ * @param identifier A token holding the identifier to look up.
+ * @param source The source code as a String (with the libraries' text).
+ * @param library Output, the library the macro comes from, NULL for a macro of the file itself.
+ * @return Pointer to the macro with that identifier, NULL if there is none.
+ */
+static Macro *find_macro(Preprocessor *preprocessor, Token identifier, String source, MacroLibrary **library) {
+    const char *text;
+    unsigned long hash;
+    unsigned long index;
+    MacroList *cell;
+    const Macro *macro;
+    unsigned int cell_value;
+    unsigned int i;
+
+    text = token_text(identifier, source);
+    hash = compute_string_hash(text, identifier.length);
+    *library = NULL;
+
+    /* The table is never full, so the probe always reaches an empty cell */
+    index = hash % preprocessor->macro_table_size;
+    while ((cell = preprocessor->macro_table[index]) != NULL) {
+        if (token_equals(identifier, cell->macro.identifier, source)) {
+            return &cell->macro;
+        }
+        index = (index + 1) % preprocessor->macro_table_size; /* Move to next cell, wrap around if necessary */
+    }
+
+    /* The libraries' indexes use the same hash, their identifiers are in their text at base */
+    for (i = 0; i < preprocessor->library_count; i++) {
+        index = hash % preprocessor->libraries[i].table_size;
+        while ((cell_value = preprocessor->libraries[i].table[index]) != 0) {
+            macro = &preprocessor->libraries[i].macros[cell_value - 1];
+            if (macro->identifier.length == identifier.length &&
+                memcmp(source.data + preprocessor->libraries[i].base + macro->identifier.index, text, identifier.length) == 0) {
+                *library = &preprocessor->libraries[i];
+                return (Macro *) macro; /* The image is read only, callers never write through it */
+            }
+            index = (index + 1) % preprocessor->libraries[i].table_size;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Maps in a library's precompiled image, if there is one and it was built from the library's current text.
+ *
+ * @param library The library, its path is set.
+ * @param text_length The length of the library's text.
+ * @param content_hash The hash of the library's text.
+ * @return true if the image was mapped in and attached, false if it is missing or stale.
+ */
+static bool map_library_image(MacroLibrary *library, unsigned int text_length, unsigned long content_hash) {
+    char *image_path;
+    struct stat status;
+    void *image;
+    const LibraryImageHeader *header;
+    int descriptor;
+
+    image_path = safe_malloc(strlen(library->path) + sizeof(LIBRARY_IMAGE_EXTENSION));
+    sprintf(image_path, "%s%s", library->path, LIBRARY_IMAGE_EXTENSION);
+    descriptor = open(image_path, O_RDONLY);
+    free(image_path);
+    if (descriptor < 0)
+        return false;
+
+    if (fstat(descriptor, &status) != 0 || (unsigned long) status.st_size < sizeof(LibraryImageHeader)) {
+        close(descriptor);
+        return false;
+    }
+    image = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (image == MAP_FAILED)
+        return false;
+
+    /* The image must come from this build's layout and from the library's current text */
+    header = image;
+    if (header->magic != LIBRARY_IMAGE_MAGIC || header->token_size != sizeof(Token) ||
+        header->macro_size != sizeof(Macro) || header->content_hash != content_hash ||
+        header->text_length != text_length || header->token_count > (unsigned long) status.st_size / sizeof(Token) ||
+        header->macro_count > (unsigned long) status.st_size / sizeof(Macro) ||
+        header->table_size > (unsigned long) status.st_size / sizeof(unsigned int) ||
+        library_image_size(header) != (unsigned long) status.st_size) {
+        munmap(image, status.st_size);
+        return false;
+    }
+
+    library->image = image;
+    library->image_size = status.st_size;
+    library->mapped = true;
+    attach_library_image(library);
+
+    /* A corrupt image is built again, as a stale one is */
+    if (!check_library_image(library)) {
+        munmap(image, status.st_size);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Lexes a library, collects its macros and builds its precompiled image, which is kept in memory for this run
+ * and written next to the library (path.amc) for the next ones.
+ *
+ * @param library The library, its path is set.
+ * @param lexer A lexer over the library's text, nothing lexed yet.
+ * @param content_hash The hash of the library's text.
+ * @return true if the library is free of errors and its image is attached, false otherwise.
+ */
+static bool build_library_image(MacroLibrary *library, Lexer *lexer, unsigned long content_hash) {
+    Preprocessor collector;
+    LibraryImageHeader header;
+    MacroList *node;
+    Macro *macros;
+    unsigned int *table;
+    unsigned long index;
+    char *image_path;
+    char *temporary_path;
+    FILE *file;
+    bool valid;
+    bool written;
+    unsigned int i;
+
+    lexer_analyze(lexer);
+    error_handler_report_errors(&lexer->error_handler);
+    if (lexer->error_handler.error_list != NULL)
+        return false;
+
+    /* The library's macros are collected by a preprocessor of its own, its errors name the library file */
+    preprocessor_initialize(&collector, lexer, library->path);
+
+    preprocessor_generate_macro_list(&collector, lexer->source_code);
+    check_macro_only(&collector);
+    error_handler_report_errors(&collector.error_handler);
+    valid = collector.error_handler.error_list == NULL;
+
+    if (valid) {
+        header.magic = LIBRARY_IMAGE_MAGIC;
+        header.content_hash = content_hash;
+        header.text_length = lexer->source_code.length - 1;
+        header.token_size = sizeof(Token);
+        header.macro_size = sizeof(Macro);
+        header.token_count = lexer->tokens.count;
+        header.macro_count = collector.macro_count;
+        header.table_size = (unsigned int) (collector.macro_count / 0.75) + 1; /* Never full, probes always end */
+
+        library->image_size = library_image_size(&header);
+        library->image = safe_calloc(library->image_size, 1);
+        library->mapped = false;
+        memcpy(library->image, &header, sizeof(LibraryImageHeader));
+        attach_library_image(library);
+
+        memcpy((Token *) library->tokens, lexer->tokens.data, header.token_count * sizeof(Token));
+        macros = (Macro *) library->macros;
+        table = (unsigned int *) library->table;
+        for (node = collector.macro_list, i = 0; node != NULL; node = node->next, i++) {
+            macros[i] = node->macro;
+            index = compute_string_hash(token_text(node->macro.identifier, lexer->source_code), node->macro.identifier.length)
+                    % header.table_size;
+            while (table[index] != 0) {
+                index = (index + 1) % header.table_size; /* Move to next cell, wrap around if necessary */
+            }
+            table[index] = i + 1;
+        }
+
+        /* Written with one fwrite under a temporary name and renamed, so a reader never maps a partial image.
+         * When the directory is not writable the library is simply built again next time */
+        image_path = safe_malloc(strlen(library->path) + sizeof(LIBRARY_IMAGE_EXTENSION));
+        sprintf(image_path, "%s%s", library->path, LIBRARY_IMAGE_EXTENSION);
+        /* The temporary name holds the process id, so assemblers building the same library never share it */
+        temporary_path = safe_malloc(strlen(image_path) + sizeof(".tmp") + 3 * sizeof(long) + 1);
+        sprintf(temporary_path, "%s.%ld.tmp", image_path, (long) getpid());
+        file = fopen(temporary_path, "wb");
+        if (file != NULL) {
+            written = fwrite(library->image, 1, library->image_size, file) == library->image_size;
+            if (fclose(file) == 0 && written)
+                rename(temporary_path, image_path);
+            else
+                remove(temporary_path);
+        }
+        free(temporary_path);
+        free(image_path);
+    }
+
+    preprocessor_free(&collector);
+    return valid;
+}
+
+/**
+ * Reports every line of a library that is not blank, a comment or part of a macro definition.
+ *
+ * @param collector The preprocessor that collected the library's macros.
+ */
+static void check_macro_only(Preprocessor *collector) {
+    Token *tokens;
+    MacroList *definition;
+    TokenError error;
+    unsigned int i;
+
+    tokens = collector->tokens.data;
+    definition = collector->macro_list;
+    for (i = 0; i < collector->tokens.count; i++) {
+        definition = skip_passed_definitions(definition, tokens[i].index);
+        if (definition != NULL && tokens[i].index >= (unsigned int) definition->macro.start_index)
+            continue;
+        if (tokens[i].type == TOKEN_EOL || tokens[i].type == TOKEN_EOFT)
+            continue;
+
+        /* One error per line */
+        error.message = string_create_from_cstr("Only macro definitions may appear in a macro library");
+        error.token = tokens[i];
+        error_handler_add_token_error(&collector->error_handler, PREPROCCESSOR_ERROR_TYPE, error);
+        while (i + 1 < collector->tokens.count && tokens[i + 1].type != TOKEN_EOL && tokens[i + 1].type != TOKEN_EOFT) {
+            i++;
+        }
+    }
+}
+
+/**
+ * Points a library at the tokens, macros and hash index inside its image.
+ *
+ * @param library The library, its image is set.
+ */
+static void attach_library_image(MacroLibrary *library) {
+    const LibraryImageHeader *header;
+    const char *image;
+
+    header = library->image;
+    image = library->image;
+    library->tokens = (const Token *) (image + sizeof(LibraryImageHeader));
+    library->macros = (const Macro *) (library->tokens + header->token_count);
+    library->table = (const unsigned int *) (library->macros + header->macro_count);
+    library->macro_count = header->macro_count;
+    library->table_size = header->table_size;
+}
+
+/**
+ * Computes the size of the image a header describes.
+ *
+ * @param header The image's header.
+ * @return The size of the image in bytes.
+ */
+static unsigned long library_image_size(const LibraryImageHeader *header) {
+    return sizeof(LibraryImageHeader) + (unsigned long) header->token_count * sizeof(Token) +
+           (unsigned long) header->macro_count * sizeof(Macro) + (unsigned long) header->table_size * sizeof(unsigned int);
+}
+
+/**
+ * Checks that everything a mapped image holds stays inside it and inside the library's text: every token,
+ * every macro's identifier, content and body, and every cell of the hash index, which must have an empty cell.
+ *
+ * The image's size was checked against its header's counts before it was attached.
+ *
+ * @param library The library, its image is attached.
+ * @return true if the image can be used, false if it is corrupt.
+ */
+static bool check_library_image(const MacroLibrary *library) {
+    const LibraryImageHeader *header;
+    const Token *token;
+    const Macro *macro;
+    unsigned int text_length;
+    unsigned int empty_cells;
+    unsigned int i;
+
+    header = library->image;
+    text_length = header->text_length;
+    if (header->table_size <= header->macro_count)
+        return false;
+
+    /* A token's text is in the library's, the EOF token sits right past it */
+    for (i = 0; i < header->token_count; i++) {
+        token = &library->tokens[i];
+        if (token->type > TOKEN_EOFT || token->expansion != 0 ||
+            token->index > text_length || token->length > text_length - token->index)
+            return false;
+    }
+
+    for (i = 0; i < header->macro_count; i++) {
+        macro = &library->macros[i];
+        if (macro->body_start > macro->body_end || macro->body_end > header->token_count ||
+            macro->identifier.index > text_length || macro->identifier.length > text_length - macro->identifier.index ||
+            macro->content_start > text_length || macro->content_length > text_length - macro->content_start)
+            return false;
+    }
+
+    empty_cells = 0;
+    for (i = 0; i < header->table_size; i++) {
+        if (library->table[i] > header->macro_count)
+            return false;
+        if (library->table[i] == 0)
+            empty_cells++;
+    }
+    return empty_cells > 0; /* Probes end at an empty cell */
+}
+
+/**
+ * Builds the path of a library from the text of its .include. A relative path is taken from the directory of the
+ * including file, so an assembler run from elsewhere finds the same library.
+ *
+ * @param including_path The path of the file holding the .include.
+ * @param text The library's path as written (not terminated).
+ * @param length The length of text.
+ * @return The library's path, allocated.
+ */
+static char *resolve_library_path(const char *including_path, const char *text, unsigned int length) {
+    const char *separator;
+    unsigned int directory_length;
+    char *path;
+
+    separator = strrchr(including_path, '/');
+    directory_length = (length > 0 && text[0] == '/') || separator == NULL ? 0 : (unsigned int) (separator + 1 - including_path);
+
+    path = safe_malloc(directory_length + length + 1);
+    memcpy(path, including_path, directory_length);
+    memcpy(path + directory_length, text, length);
+    path[directory_length + length] = '\0';
+    return path;
+}
+
+/**
+ * Appends a library's text to the source, past the file's EOF sentinel, and records it as a region of the
+ * library's file with its own line starts, so a diagnostic in a library body names the library and its line.
+ *
+ * @param preprocessor The preprocessor.
+ * @param text The library's text (ending with its EOF sentinel, which is not appended).
+ * @param file_path The path of the library's file.
+ * @return The offset of the library's text in the source.
+ */
+static unsigned int append_library_text(Preprocessor *preprocessor, String text, const char *file_path) {
+    Lexer *lexer;
+    unsigned int base;
+    const char *newline;
+    const char *end;
+
+    lexer = preprocessor->lexer;
+    base = lexer->source_code.length;
+    string_append_chars(&lexer->source_code, text.data, text.length - 1);
+    lexer->source_code.data[lexer->source_code.length] = '\0';
+
+    line_index_add_region(&lexer->line_index, base, file_path);
+    line_index_add(&lexer->line_index, base);
+    end = lexer->source_code.data + lexer->source_code.length;
+    newline = memchr(lexer->source_code.data + base, '\n', end - (lexer->source_code.data + base));
+    while (newline != NULL) {
+        line_index_add(&lexer->line_index, newline + 1 - lexer->source_code.data);
+        newline = memchr(newline + 1, '\n', end - (newline + 1));
+    }
+
+    /* The text may have moved, everything that holds it is pointed at the new one */
+    preprocessor->source_code = lexer->source_code;
+    lexer->error_handler.string = lexer->source_code;
+    preprocessor->error_handler.string = lexer->source_code;
+    return base;
 }
@@ -42,4 +42,64 @@ void *safe_calloc(size_t __nmemb, size_t __size) {
     }
     
     return out;
-}
\ No newline at end of file
+}
+
+/* Every block is aligned for the strictest of the basic types */
+typedef union ArenaAlignment {
+    long l;
+    double d;
+    void *p;
+} ArenaAlignment;
+
+#define ARENA_ALIGN(size) (((size) + sizeof(ArenaAlignment) - 1) / sizeof(ArenaAlignment) * sizeof(ArenaAlignment))
+
+void arena_initialize(Arena *arena, size_t slab_size) {
+    arena->slabs = NULL;
+    arena->slab_size = ARENA_ALIGN(slab_size > 0 ? slab_size : 1);
+}
+
+void *arena_allocate(Arena *arena, size_t size) {
+    ArenaSlab *slab = arena->slabs;
+    void *block;
+
+    size = ARENA_ALIGN(size);
+    if (slab == NULL || slab->used + size > slab->capacity) {
+        /* The slab header is padded, so the first block is aligned too */
+        while (arena->slab_size < size) {
+            arena->slab_size *= 2;
+        }
+        slab = safe_malloc(ARENA_ALIGN(sizeof(ArenaSlab)) + arena->slab_size);
+        slab->next = arena->slabs;
+        slab->used = 0;
+        slab->capacity = arena->slab_size;
+        arena->slabs = slab;
+        arena->slab_size *= 2;
+    }
+
+    block = (char *) slab + ARENA_ALIGN(sizeof(ArenaSlab)) + slab->used;
+    slab->used += size;
+    return block;
+}
+
+void arena_free(Arena *arena) {
+    ArenaSlab *slab = arena->slabs;
+    ArenaSlab *next;
+
+    while (slab != NULL) {
+        next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    arena->slabs = NULL;
+}
+
+void arena_absorb(Arena *arena, Arena *other) {
+    ArenaSlab **last = &arena->slabs;
+
+    /* The other slabs go behind this arena's, so its current slab is still the one handed out from */
+    while (*last != NULL) {
+        last = &(*last)->next;
+    }
+    *last = other->slabs;
+    other->slabs = NULL;
+}
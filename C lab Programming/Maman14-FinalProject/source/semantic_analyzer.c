@@ -3,10 +3,6 @@
 #include "../headers/string_util.h"
 #include <stdio.h>
 
-/* Maximum positive value for a 15-bit signed integer */
-#define MAX_15BIT_SIGNED_INT  (signed int)(((2 << (14-1))) -1)
-/* Minimum negative value for a 15-bit signed integer */
-#define MIN_15BIT_SIGNED_INT (signed int)(-(2 << (14-1)))
 /* Maximum positive value for a 12-bit signed integer */
 #define MAX_12BIT_SIGNED_INT  (signed int)(((2 << (11-1))) -1)
 /* Minimum negative value for a 12-bit signed integer */
@@ -14,7 +10,8 @@
 
 static void report_error(SemanticAnalyzer *analyzer, const char *message, Token *token);
 static int get_expected_operand_count(TokenType operation_type);
-static AddressingMode validate_and_determine_addressing_mode(SemanticAnalyzer *analyzer, Token *operand_token, bool is_dereferenced);
+static void analyze_instruction_row(SemanticAnalyzer *analyzer, InstructionTable *table, unsigned int row);
+static void validate_operand(SemanticAnalyzer *analyzer, AddressingMode mode, int value, bool is_dereferenced, Token *operand_token);
 static void validate_identifier(SemanticAnalyzer *analyzer, Token *token);
 static void validate_entry_declarations(SemanticAnalyzer *analyzer, EntryNodeList *entry_node_list);
 static void validate_external_declarations(SemanticAnalyzer *analyzer, ExternalNodeList *external_node_list);
@@ -22,18 +19,7 @@ static void validate_guidance_labels(SemanticAnalyzer *analyzer, LabelNodeList *
 static void validate_instruction_labels(SemanticAnalyzer *analyzer, LabelNodeList *instruction_label_list);
 static void validate_label_list(SemanticAnalyzer *analyzer, LabelNodeList *label_list);
 
-unsigned long compute_string_hash(String str) {
-    unsigned long h = 5381;
-    unsigned char *us = (unsigned char *) str.data;
-
-    while (*us) {
-        h = ((h << 5) + h) + *us++;
-    }
-
-    return h;
-}
-
-void semantic_analyzer_initialize(SemanticAnalyzer *analyzer, TranslationUnit *unit, Lexer lexer) {
+void semantic_analyzer_initialize(SemanticAnalyzer *analyzer, TranslationUnit *unit, Lexer *lexer) {
     ExternalNodeList *externalNodeList;
     LabelNodeList *instructionLabelList;
     LabelNodeList *guidanceLabelList;
@@ -41,6 +27,8 @@ void semantic_analyzer_initialize(SemanticAnalyzer *analyzer, TranslationUnit *u
     ExternalNodeList *extList;
 
     analyzer->size = 0;
+    analyzer->instructions = &unit->instructions;
+    analyzer->tokens = unit->tokens.data;
 
     instructionLabelList = unit->instruction_label_list;
     guidanceLabelList = unit->guidance_label_list;
@@ -63,7 +51,7 @@ void semantic_analyzer_initialize(SemanticAnalyzer *analyzer, TranslationUnit *u
     analyzer->size = (unsigned int) (analyzer->size / 0.75) + 1;
     analyzer->hash = safe_calloc(analyzer->size, sizeof(IdentifierCell));
 
-    error_handler_initialize(&analyzer->error_handler, lexer.source_code, lexer.file_path);
+    error_handler_initialize(&analyzer->error_handler, lexer->source_code, &lexer->line_index, lexer->file_path);
 }
 
 void semantic_analyzer_free(SemanticAnalyzer *analyzer) {
@@ -84,7 +72,7 @@ void semantic_analyzer_free(SemanticAnalyzer *analyzer) {
     /* Note: We don't free Semantic Analyzer itself as it might not have been dynamically allocated */
 }
 
-IdentifierCell *semantic_analyzer_find_identifier(SemanticAnalyzer *analyzer, String key) {
+IdentifierCell *semantic_analyzer_find_identifier(SemanticAnalyzer *analyzer, Token key) {
     unsigned long index;
     unsigned long start_index;
 
@@ -92,7 +80,7 @@ IdentifierCell *semantic_analyzer_find_identifier(SemanticAnalyzer *analyzer, St
         return NULL; /* Return NULL if the validator or hash table is invalid */
     }
 
-    index = compute_string_hash(key) % analyzer->size;
+    index = compute_string_hash(token_text(key, analyzer->error_handler.string), key.length) % analyzer->size;
     start_index = index;
 
     do {
@@ -102,7 +90,7 @@ IdentifierCell *semantic_analyzer_find_identifier(SemanticAnalyzer *analyzer, St
             return NULL; /* Empty cell, key not found */
         }
 
-        if (string_equals(key, *cell->key)) {
+        if (token_equals(key, *cell->key, analyzer->error_handler.string)) {
             return cell; /* Key found */
         }
 
@@ -121,7 +109,7 @@ bool semantic_analyzer_insert_identifier(SemanticAnalyzer *analyzer, IdentifierC
         return false; /* Invalid validator or hash table */
     }
 
-    hashValue = compute_string_hash(*cell.key);
+    hashValue = compute_string_hash(token_text(*cell.key, analyzer->error_handler.string), cell.key->length);
     index = hashValue % analyzer->size;
     startIndex = index;
 
@@ -135,7 +123,7 @@ bool semantic_analyzer_insert_identifier(SemanticAnalyzer *analyzer, IdentifierC
         }
 
         /* Check for duplicate key */
-        if (string_equals(*cell.key, *analyzer->hash[index].key)) {
+        if (token_equals(*cell.key, *analyzer->hash[index].key, analyzer->error_handler.string)) {
             return false; /* Duplicate key found, insertion fails */
         }
 
@@ -146,130 +134,56 @@ bool semantic_analyzer_insert_identifier(SemanticAnalyzer *analyzer, IdentifierC
 }
 
 void semantic_analyzer_analyze_directive_guidance(SemanticAnalyzer *analyzer, DataNode node) {
-    TokenReferenceNode *current;
-    int value;
+    Token *current;
 
     if (analyzer == NULL) {
         fprintf(stderr, "Error: Null Semantic Analyzer passed to semantic_analyzer_data_node\n");
         return;
     }
 
-    current = node.data_numbers;
-    while (current != NULL) {
-        if (current->token == NULL) {
-            fprintf(stderr, "Error: Null token in data node\n");
-            continue;
-        }
+    /* The parser already checked the values, the tokens are only revisited to point at the bad ones */
+    if (!node.is_out_of_range || node.first_number == NULL) {
+        return;
+    }
 
-        value = atoi(current->token->string.data);
-        if (value > MAX_15BIT_SIGNED_INT || value < MIN_15BIT_SIGNED_INT) {
-            report_error(analyzer, "Integer value is out of the allowed range", current->token);
+    for (current = node.first_number; current->type != TOKEN_EOL && current->type != TOKEN_EOFT; current++) {
+        if (current->type == TOKEN_NUMBER && (current->is_overflow ||
+            current->value > MAX_15BIT_SIGNED_INT || current->value < MIN_15BIT_SIGNED_INT)) {
+            report_error(analyzer, "Integer value is out of the allowed range", current);
         }
-
-        current = current->next;
     }
 }
 
 void semantic_analyzer_analyze_instruction(SemanticAnalyzer *analyzer, InstructionNode node) {
-    Token *source;
-    bool isSourceDereferenced;
-    Token *destination;
-    bool isDestinationDereferenced;
-    AddressingMode sourceAM;
-    AddressingMode destinationAM;
-    Token *operation;
-    int expectedOperandCount;
-    int actualOperandCount;
+    InstructionTable table;
+    unsigned char opcode, source_mode, destination_mode, flags;
+    int source_value, destination_value;
+    unsigned int token, source_token, destination_token;
 
     if (analyzer == NULL || node.operation == NULL) {
         fprintf(stderr, "Error: Invalid parameters passed to semantic_analyzer_analyze_instruction\n");
         return;
     }
 
-    source = node.first_operand;
-    isSourceDereferenced = node.is_first_operand_derefrenced;
-    destination = node.second_operand;
-    isDestinationDereferenced = node.is_second_operand_derefrenced;
-    sourceAM = ADDRESSING_MODE_IMMEDIATE;
-    destinationAM = ADDRESSING_MODE_IMMEDIATE;
-    operation = node.operation;
-
-    /* Validate operand count */
-    expectedOperandCount = get_expected_operand_count(operation->type);
-    actualOperandCount = (source != NULL) + (destination != NULL);
-
-    if (actualOperandCount != expectedOperandCount) {
-        report_error(analyzer, "Invalid number of operands", operation);
-        return;
-    }
-
-    /* Validate addressing modes and identifiers */
-    if (source != NULL) {
-        sourceAM = validate_and_determine_addressing_mode(analyzer, source, isSourceDereferenced);
-        if (source->type == TOKEN_IDENTIFIER) {
-            validate_identifier(analyzer, source);
-        }
-    }
-    if (destination != NULL) {
-        destinationAM = validate_and_determine_addressing_mode(analyzer, destination, isDestinationDereferenced);
-        if (destination->type == TOKEN_IDENTIFIER) {
-            validate_identifier(analyzer, destination);
-        }
-    }
-
-    /* Validate operation-specific requirements */
-    switch (operation->type) {
-        case TOKEN_MOV:
-        case TOKEN_ADD:
-        case TOKEN_SUB:
-        case TOKEN_CMP:
-            if (sourceAM == ADDRESSING_MODE_IMMEDIATE && destinationAM == ADDRESSING_MODE_IMMEDIATE) {
-                report_error(analyzer, "Both operands cannot be immediate", operation);
-            }
-            break;
-        case TOKEN_NOT:
-        case TOKEN_CLR:
-        case TOKEN_INC:
-        case TOKEN_DEC:
-            if (sourceAM == ADDRESSING_MODE_IMMEDIATE) {
-                report_error(analyzer, "Operand cannot be immediate for this instruction", source);
-            }
-            break;
-        case TOKEN_LEA:
-            if (sourceAM != ADDRESSING_MODE_DIRECT) {
-                report_error(analyzer, "LEA source must be a label", source);
-            }
-            if (destinationAM != ADDRESSING_MODE_DIRECT_REGISTER && destinationAM != ADDRESSING_MODE_INDIRECT_REGISTER) {
-                report_error(analyzer, "LEA destination must be a register", destination);
-            }
-            break;
-        case TOKEN_JMP:
-        case TOKEN_BNE:
-        case TOKEN_JSR:
-            if (sourceAM != ADDRESSING_MODE_DIRECT && sourceAM != ADDRESSING_MODE_INDIRECT_REGISTER) {
-                report_error(analyzer, "Invalid addressing mode for jump instruction", source);
-            }
-            break;
-        case TOKEN_RED:
-            if (sourceAM == ADDRESSING_MODE_IMMEDIATE) {
-                report_error(analyzer, "RED operand cannot be immediate", source);
-            }
-            break;
-        case TOKEN_PRN:
-            /* PRN accepts all addressing modes, so no additional checks needed */
-            break;
-        case TOKEN_RTS:
-        case TOKEN_STOP:
-            /* No operands, so no additional checks needed */
-            break;
-        default:
-            report_error(analyzer, "Unknown operation type", operation);
-            break;
-    }
+    /* Validate the node as the single row of a table on the stack */
+    table.opcode = &opcode;
+    table.source_mode = &source_mode;
+    table.destination_mode = &destination_mode;
+    table.flags = &flags;
+    table.source_value = &source_value;
+    table.destination_value = &destination_value;
+    table.token = &token;
+    table.source_token = &source_token;
+    table.destination_token = &destination_token;
+    table.count = 0;
+    table.capacity = 1;
+
+    parser_append_instruction_row(&table, analyzer->tokens, node);
+    analyze_instruction_row(analyzer, &table, 0);
 }
 
 void semantic_analyzer_analyze_label(SemanticAnalyzer *analyzer, LabelNode node) {
-    InstructionNodeList *currentInstruction;
+    unsigned int row;
     GuidanceNodeList *currentGuidance;
 
     if (analyzer == NULL) {
@@ -277,16 +191,9 @@ void semantic_analyzer_analyze_label(SemanticAnalyzer *analyzer, LabelNode node)
         return;
     }
 
-    /* Check if a label with instructions has a label identifier */
-    if (node.instruction_list != NULL && node.label == NULL) {
-        report_error(analyzer, "A label with instructions should have a label identifier", node.instruction_list->node.first_operand);
-    }
-
-    /* Validate all instruction nodes */
-    currentInstruction = node.instruction_list;
-    while (currentInstruction != NULL) {
-        semantic_analyzer_analyze_instruction(analyzer, currentInstruction->node);
-        currentInstruction = currentInstruction->next;
+    /* Validate the label's rows of the instruction table */
+    for (row = node.first_instruction; row < node.first_instruction + node.instruction_count; row++) {
+        analyze_instruction_row(analyzer, analyzer->instructions, row);
     }
 
     /* Validate all guidance nodes */
@@ -359,53 +266,157 @@ static void report_error(SemanticAnalyzer *analyzer, const char *message, Token
 }
 
 /**
- * Determines the addressing mode of an operand and validates its correctness.
+ * Validates one row of an instruction table.
  *
- * This function analyzes the given operand token and its dereference status
- * to determine the appropriate addressing mode. It also performs validation
- * checks, reporting errors for invalid combinations or out-of-range values.
+ * This function reads the row's operation, operand modes, values and dereference flags,
+ * then checks the operand count, every operand and the addressing modes the operation allows,
+ * reporting an error for each invalid combination or out-of-range value.
  *
  * @param analyzer Pointer to the Analyzer structure.
- * @param operand_token Pointer to the token representing the operand.
- * @param is_dereferenced Boolean indicating whether the operand is dereferenced.
- * @return The determined AddressingMode of the operand.
+ * @param table Pointer to the instruction table holding the row.
+ * @param row The index of the row to validate.
  */
-static AddressingMode validate_and_determine_addressing_mode(SemanticAnalyzer *analyzer, Token *operand_token, bool is_dereferenced) {
-    AddressingMode mode;
-    int value;
-
-    switch (operand_token->type) {
-        case TOKEN_NUMBER:
-            if (is_dereferenced) {
-                report_error(analyzer, "A number cannot be dereferenced", operand_token);
-            }
+static void analyze_instruction_row(SemanticAnalyzer *analyzer, InstructionTable *table, unsigned int row) {
+    Token *source;
+    bool isSourceDereferenced;
+    Token *destination;
+    bool isDestinationDereferenced;
+    AddressingMode sourceAM;
+    AddressingMode destinationAM;
+    Token *operation;
+    int sourceValue;
+    int destinationValue;
+    int expectedOperandCount;
+    int actualOperandCount;
 
-        value = atoi(operand_token->string.data);
-        if (value > MAX_12BIT_SIGNED_INT || value < MIN_12BIT_SIGNED_INT) {
-            report_error(analyzer, "Integer value is out of the allowed range", operand_token);
+    operation = &analyzer->tokens[table->token[row]];
+    source = NULL;
+    destination = NULL;
+    isSourceDereferenced = false;
+    isDestinationDereferenced = false;
+    sourceAM = ADDRESSING_MODE_IMMEDIATE;
+    destinationAM = ADDRESSING_MODE_IMMEDIATE;
+    sourceValue = 0;
+    destinationValue = 0;
+
+    /* The checks below go by the operands as written, a lone one comes first */
+    if (table->source_mode[row] != 0) {
+        source = &analyzer->tokens[table->source_token[row]];
+        sourceAM = (AddressingMode) table->source_mode[row];
+        sourceValue = table->source_value[row];
+        isSourceDereferenced = (table->flags[row] & INSTRUCTION_SOURCE_DEREFERENCED) != 0;
+        if (table->destination_mode[row] != 0) {
+            destination = &analyzer->tokens[table->destination_token[row]];
+            destinationAM = (AddressingMode) table->destination_mode[row];
+            destinationValue = table->destination_value[row];
+            isDestinationDereferenced = (table->flags[row] & INSTRUCTION_DESTINATION_DEREFERENCED) != 0;
         }
+    } else if (table->destination_mode[row] != 0) {
+        source = &analyzer->tokens[table->destination_token[row]];
+        sourceAM = (AddressingMode) table->destination_mode[row];
+        sourceValue = table->destination_value[row];
+        isSourceDereferenced = (table->flags[row] & INSTRUCTION_DESTINATION_DEREFERENCED) != 0;
+    }
+
+    /* Validate operand count */
+    expectedOperandCount = get_expected_operand_count(operation->type);
+    actualOperandCount = (source != NULL) + (destination != NULL);
+
+    if (actualOperandCount != expectedOperandCount) {
+        report_error(analyzer, "Invalid number of operands", operation);
+        return;
+    }
+
+    /* Validate operand values and identifiers */
+    if (source != NULL) {
+        validate_operand(analyzer, sourceAM, sourceValue, isSourceDereferenced, source);
+    }
+    if (destination != NULL) {
+        validate_operand(analyzer, destinationAM, destinationValue, isDestinationDereferenced, destination);
+    }
+
+    /* Validate operation-specific requirements */
+    switch (operation->type) {
+        case TOKEN_MOV:
+        case TOKEN_ADD:
+        case TOKEN_SUB:
+        case TOKEN_CMP:
+            if (sourceAM == ADDRESSING_MODE_IMMEDIATE && destinationAM == ADDRESSING_MODE_IMMEDIATE) {
+                report_error(analyzer, "Both operands cannot be immediate", operation);
+            }
+            break;
+        case TOKEN_NOT:
+        case TOKEN_CLR:
+        case TOKEN_INC:
+        case TOKEN_DEC:
+            if (sourceAM == ADDRESSING_MODE_IMMEDIATE) {
+                report_error(analyzer, "Operand cannot be immediate for this instruction", source);
+            }
+            break;
+        case TOKEN_LEA:
+            if (sourceAM != ADDRESSING_MODE_DIRECT) {
+                report_error(analyzer, "LEA source must be a label", source);
+            }
+            if (destinationAM != ADDRESSING_MODE_DIRECT_REGISTER && destinationAM != ADDRESSING_MODE_INDIRECT_REGISTER) {
+                report_error(analyzer, "LEA destination must be a register", destination);
+            }
+            break;
+        case TOKEN_JMP:
+        case TOKEN_BNE:
+        case TOKEN_JSR:
+            if (sourceAM != ADDRESSING_MODE_DIRECT && sourceAM != ADDRESSING_MODE_INDIRECT_REGISTER) {
+                report_error(analyzer, "Invalid addressing mode for jump instruction", source);
+            }
+            break;
+        case TOKEN_RED:
+            if (sourceAM == ADDRESSING_MODE_IMMEDIATE) {
+                report_error(analyzer, "RED operand cannot be immediate", source);
+            }
+            break;
+        case TOKEN_PRN:
+            /* PRN accepts all addressing modes, so no additional checks needed */
+            break;
+        case TOKEN_RTS:
+        case TOKEN_STOP:
+            /* No operands, so no additional checks needed */
+            break;
+        default:
+            report_error(analyzer, "Unknown operation type", operation);
+            break;
+    }
+}
 
-        mode = ADDRESSING_MODE_IMMEDIATE;
+/**
+ * Validates a single operand of an instruction.
+ *
+ * An immediate value must fit 12 bits, and a label must not be dereferenced
+ * and must be a valid identifier. Registers are valid in every mode.
+ *
+ * @param analyzer Pointer to the Analyzer structure.
+ * @param mode The addressing mode of the operand.
+ * @param value The operand's immediate value or register number (0 for a label).
+ * @param is_dereferenced Boolean indicating whether the operand is dereferenced.
+ * @param operand_token Pointer to the token representing the operand.
+ */
+static void validate_operand(SemanticAnalyzer *analyzer, AddressingMode mode, int value, bool is_dereferenced, Token *operand_token) {
+    switch (mode) {
+        case ADDRESSING_MODE_IMMEDIATE:
+            if (value > MAX_12BIT_SIGNED_INT || value < MIN_12BIT_SIGNED_INT) {
+                report_error(analyzer, "Integer value is out of the allowed range", operand_token);
+            }
         break;
 
-        case TOKEN_IDENTIFIER:
+        case ADDRESSING_MODE_DIRECT:
             if (is_dereferenced) {
                 report_error(analyzer, "A label cannot be dereferenced", operand_token);
             }
-        mode = ADDRESSING_MODE_DIRECT;
-        break;
-
-        case TOKEN_REGISTER:
-            mode = is_dereferenced ? ADDRESSING_MODE_INDIRECT_REGISTER : ADDRESSING_MODE_DIRECT_REGISTER;
+            validate_identifier(analyzer, operand_token);
         break;
 
         default:
-            report_error(analyzer, "Invalid operand syntax", operand_token);
-        mode = ADDRESSING_MODE_IMMEDIATE; /* Default to absolute as a fallback */
+            /* Registers are valid either way */
         break;
     }
-
-    return mode;
 }
 
 /**
@@ -447,7 +458,7 @@ static int get_expected_operand_count(TokenType operation_type) {
  * @param token The token containing the identifier to validate.
  */
 static void validate_identifier(SemanticAnalyzer *analyzer, Token *token) {
-    if (semantic_analyzer_find_identifier(analyzer, token->string) == NULL) {
+    if (semantic_analyzer_find_identifier(analyzer, *token) == NULL) {
         report_error(analyzer, "Unknown identifier", token);
     }
 }
@@ -459,7 +470,7 @@ static void validate_instruction_labels(SemanticAnalyzer *analyzer, LabelNodeLis
     IdentifierCell cell;
 
     while (instruction_label_list != NULL) {
-        cell.key = &instruction_label_list->label.label->string;
+        cell.key = instruction_label_list->label.label;
         cell.type = IDENTIFIER_CELL_LABEL;
         cell.value.label = &instruction_label_list->label;
 
@@ -478,7 +489,7 @@ static void validate_guidance_labels(SemanticAnalyzer *analyzer, LabelNodeList *
     IdentifierCell cell;
     while (guidance_label_list != NULL) {
         if (guidance_label_list->label.label != NULL) {
-            cell.key = &guidance_label_list->label.label->string;
+            cell.key = guidance_label_list->label.label;
             cell.type = IDENTIFIER_CELL_LABEL;
             cell.value.label = &guidance_label_list->label;
 
@@ -499,10 +510,10 @@ static void validate_external_declarations(SemanticAnalyzer *analyzer, ExternalN
     IdentifierCell newCell;
 
     while (external_node_list != NULL) {
-        IdentifierCell *existingCell = semantic_analyzer_find_identifier(analyzer, external_node_list->external_node.external_label->string);
+        IdentifierCell *existingCell = semantic_analyzer_find_identifier(analyzer, *external_node_list->external_node.external_label);
 
         if (existingCell == NULL) {
-            newCell.key = &external_node_list->external_node.external_label->string;
+            newCell.key = external_node_list->external_node.external_label;
             newCell.type = IDENTIFIER_CELL_EXTERNAL;
             newCell.value.external = &external_node_list->external_node;
             semantic_analyzer_insert_identifier(analyzer, newCell);
@@ -523,7 +534,7 @@ static void validate_external_declarations(SemanticAnalyzer *analyzer, ExternalN
  */
 static void validate_entry_declarations(SemanticAnalyzer *analyzer, EntryNodeList *entry_node_list) {
     while (entry_node_list != NULL) {
-        IdentifierCell *existingCell = semantic_analyzer_find_identifier(analyzer, entry_node_list->entry_node.entry_label->string);
+        IdentifierCell *existingCell = semantic_analyzer_find_identifier(analyzer, *entry_node_list->entry_node.entry_label);
 
         if (existingCell == NULL) {
             report_error(analyzer,"Entry point has no corresponding label declaration", entry_node_list->entry_node.entry_label);
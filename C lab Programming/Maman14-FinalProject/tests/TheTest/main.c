@@ -23,20 +23,28 @@ int create_directory(const char *path) {
 }
 
 int main(int argc, char *argv[]) {
-    Lexer lexer_preprocess;
-    Lexer lexer_postprocess;
+    Lexer lexer;
     Preprocessor preprocessor;
     TranslationUnit unit;
     SemanticAnalyzer analyzer;
     CodeGenerator generator;
+    bool preprocessed;
+    bool write_am = true;
+    int first_file = 1;
     int i;
 
-    if (argc < 2) {
-        printf("Usage: %s <file1.as> [file2.as ...]\n", argv[0]);
+    /* --no-am keeps the expanded source in memory only, for runs where the .am files are never read */
+    if (argc > 1 && strcmp(argv[1], "--no-am") == 0) {
+        write_am = false;
+        first_file = 2;
+    }
+
+    if (argc <= first_file) {
+        printf("Usage: %s [--no-am] <file1.as> [file2.as ...]\n", argv[0]);
         return 1;
     }
 
-for (i = 1; i < argc; i++) {
+for (i = first_file; i < argc; i++) {
     char output_dir[256];
     char output_file[256];
     char *dot;
@@ -44,90 +52,87 @@ for (i = 1; i < argc; i++) {
 
     printf("Processing file: %s\n", argv[i]);
 
-    /* preprocess lexer */
-    if (lexer_initialize_from_file(&lexer_preprocess, argv[i]) == 1) {
-        printf("Lexical analysis (pre-process) started...\n");
-        lexer_analyze(&lexer_preprocess);
-        error_handler_report_errors(&lexer_preprocess.error_handler);
-
-        if (lexer_preprocess.error_handler.error_list == NULL) {
-            /* preprocessor */
-            printf("Preprocessing started...\n");
-            preprocessor_initialize(&preprocessor, lexer_preprocess, argv[i]);
-            preprocessor_process(&preprocessor, lexer_preprocess.source_code);
-            error_handler_report_errors(&preprocessor.error_handler);
-
-            if (preprocessor.error_handler.error_list == NULL) {
-                /* postprocess lexer */
-                printf("Lexical analysis (post-process) started...\n");
-                lexer_initialize_from_string(&lexer_postprocess, preprocessor.error_handler.file_path, preprocessor.processed_source);
-                lexer_analyze(&lexer_postprocess);
-                error_handler_report_errors(&lexer_postprocess.error_handler);
-
-                if (lexer_postprocess.error_handler.error_list == NULL) {
-                    /* parser */
-                    printf("Parsing started...\n");
-                    parser_initialize_translation_unit(&unit, lexer_postprocess);
-                    parse_translation_unit_content(&unit);
-                    error_handler_report_errors(&unit.error_handler);
-
-                    if (unit.error_handler.error_list == NULL) {
-                        /* Analyzer */
-                        printf("Semantic analysis started...\n");
-                        semantic_analyzer_initialize(&analyzer, &unit, lexer_postprocess);
-                        semantic_analyzer_analyze_translation_unit(&analyzer, &unit);
-                        error_handler_report_errors(&analyzer.error_handler);
-
-                        if (analyzer.error_handler.error_list == NULL) {
-                            /* Create output directory name */
-                            base_name = strrchr(argv[i], '/');
-                            if (base_name == NULL) {
-                                base_name = argv[i];
-                            } else {
-                                base_name++;
-                            }
-                            sprintf(output_dir, "%s_output", base_name);
-                            dot = strrchr(output_dir, '.');
-                            if (dot) *dot = '\0';
-
-                            /* Create output directory */
-                            if (!create_directory(output_dir)) {
-                                printf("Failed to create output directory for %s\n", argv[i]);
-                                continue;
-                            }
-
-                            /* Code generator */
-                            printf("Code generation started...\n");
-                            code_generator_initialize(&generator, lexer_postprocess);
-                            code_generator_update_labels(&generator, &unit);
-                            generate_entry_file_string(&generator, &analyzer, &unit);
-
-                            /* Create output file path */
-                            sprintf(output_file, "%s/%s", output_dir, base_name);
-                            dot = strrchr(output_file, '.');
-                            if (dot) *dot = '\0';
-                            strcat(output_file, ".ob");
-
-                            output_generate(&generator, &analyzer, &unit, output_file);
-                            error_handler_report_errors(&generator.error_handler);
-
-                            code_generator_free(&generator);
+    /* lexer */
+    if (lexer_initialize_from_file(&lexer, argv[i]) == 1) {
+        printf("Lexical analysis started...\n");
+        lexer_analyze(&lexer);
+        error_handler_report_errors(&lexer.error_handler);
+
+        if (lexer.error_handler.error_list == NULL) {
+            /* preprocessor, a file without a single macr or .include has nothing to expand so its tokens go straight to the parser */
+            preprocessed = lexer.macro_count > 0 || lexer.include_count > 0;
+            if (preprocessed) {
+                printf("Preprocessing started...\n");
+                preprocessor_initialize(&preprocessor, &lexer, argv[i]);
+                preprocessor.write_expanded_file = write_am;
+                preprocessor_process(&preprocessor, lexer.source_code);
+                error_handler_report_errors(&preprocessor.error_handler);
+            } else {
+                printf("No macros found, preprocessing skipped...\n");
+            }
+
+            if (!preprocessed || preprocessor.error_handler.error_list == NULL) {
+                /* parser */
+                printf("Parsing started...\n");
+                parser_initialize_translation_unit(&unit, &lexer);
+                parse_translation_unit_content(&unit);
+                error_handler_report_errors(&unit.error_handler);
+
+                if (unit.error_handler.error_list == NULL) {
+                    /* Analyzer */
+                    printf("Semantic analysis started...\n");
+                    semantic_analyzer_initialize(&analyzer, &unit, &lexer);
+                    semantic_analyzer_analyze_translation_unit(&analyzer, &unit);
+                    error_handler_report_errors(&analyzer.error_handler);
+
+                    if (analyzer.error_handler.error_list == NULL) {
+                        /* Create output directory name */
+                        base_name = strrchr(argv[i], '/');
+                        if (base_name == NULL) {
+                            base_name = argv[i];
+                        } else {
+                            base_name++;
                         }
+                        sprintf(output_dir, "%s_output", base_name);
+                        dot = strrchr(output_dir, '.');
+                        if (dot) *dot = '\0';
+
+                        /* Create output directory */
+                        if (!create_directory(output_dir)) {
+                            printf("Failed to create output directory for %s\n", argv[i]);
+                            continue;
+                        }
+
+                        /* Code generator */
+                        printf("Code generation started...\n");
+                        code_generator_initialize(&generator, &lexer);
+                        code_generator_update_labels(&generator, &unit);
+                        generate_entry_file_string(&generator, &analyzer, &unit);
+
+                        /* Create output file path */
+                        sprintf(output_file, "%s/%s", output_dir, base_name);
+                        dot = strrchr(output_file, '.');
+                        if (dot) *dot = '\0';
+                        strcat(output_file, ".ob");
+
+                        output_generate(&generator, &analyzer, &unit, output_file);
+                        error_handler_report_errors(&generator.error_handler);
 
-                        semantic_analyzer_free(&analyzer);
+                        code_generator_free(&generator);
                     }
 
-                    parser_free_translation_unit(&unit);
+                    semantic_analyzer_free(&analyzer);
                 }
 
-                lexer_free(&lexer_postprocess);
+                parser_free_translation_unit(&unit);
             }
 
-            preprocessor_free(&preprocessor);
+            if (preprocessed)
+                preprocessor_free(&preprocessor);
         }
     }
 
-    lexer_free(&lexer_preprocess);
+    lexer_free(&lexer);
     printf("Finished processing file: %s\n\n", argv[i]);
 }
 
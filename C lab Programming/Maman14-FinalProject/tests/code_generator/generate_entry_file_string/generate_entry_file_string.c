@@ -8,7 +8,6 @@
 
 int main(){
     Lexer lexer_preprocess;
-    Lexer lexer_postprocess;
     Preprocessor preprocessor;
     TranslationUnit unit;
     SemanticAnalyzer analyzer;
@@ -22,27 +21,22 @@ int main(){
     error_handler_report_errors(&lexer_preprocess.error_handler);
 
     /* preprocesser */
-    preprocessor_initialize(&preprocessor, lexer_preprocess, file_path);
+    preprocessor_initialize(&preprocessor, &lexer_preprocess, file_path);
     preprocessor_process(&preprocessor, lexer_preprocess.source_code);
     error_handler_report_errors(&preprocessor.error_handler);
 
-    /* postprocess lexer */
-    lexer_initialize_from_string(&lexer_postprocess, preprocessor.error_handler.file_path, preprocessor.processed_source);
-    lexer_analyze(&lexer_postprocess);
-    error_handler_report_errors(&lexer_postprocess.error_handler);
-
     /* parser */
-    parser_initialize_translation_unit(&unit, lexer_postprocess);
+    parser_initialize_translation_unit(&unit, &lexer_preprocess);
     parse_translation_unit_content(&unit);
     error_handler_report_errors(&unit.error_handler);
 
     /* Semantic analyzer */
-    semantic_analyzer_initialize(&analyzer, &unit, lexer_postprocess);
+    semantic_analyzer_initialize(&analyzer, &unit, &lexer_preprocess);
     semantic_analyzer_analyze_translation_unit(&analyzer, &unit);
     error_handler_report_errors(&analyzer.error_handler);
 
     /*Code Generator*/
-    code_generator_initialize(&generator, lexer_postprocess);
+    code_generator_initialize(&generator, &lexer_preprocess);
     code_generator_update_labels(&generator, &unit);
     generate_entry_file_string(&generator, &analyzer, &unit);
     error_handler_report_errors(&generator.error_handler);
@@ -53,7 +47,6 @@ int main(){
     semantic_analyzer_free(&analyzer);
     parser_free_translation_unit(&unit);
     preprocessor_free(&preprocessor);
-    lexer_free(&lexer_postprocess);
     lexer_free(&lexer_preprocess);
 
     return 0;
@@ -8,7 +8,6 @@
 
 int main() {
     Lexer lexer_pre_processor;
-    Lexer lexer_post_processor;
     Preprocessor pre_processor;
     SemanticAnalyzer analyzer;
     TranslationUnit translation_unit;
@@ -25,26 +24,21 @@ int main() {
     error_handler_report_errors(&lexer_pre_processor.error_handler);
 
     /* Postprocess lexer */
-    preprocessor_initialize(&pre_processor, lexer_pre_processor, file_path);
+    preprocessor_initialize(&pre_processor, &lexer_pre_processor, file_path);
     preprocessor_process(&pre_processor, lexer_pre_processor.source_code);
     error_handler_report_errors(&pre_processor.error_handler);
 
-    /* postprocess lexer  */
-    lexer_initialize_from_string(&lexer_post_processor, pre_processor.error_handler.file_path,pre_processor.processed_source);
-    lexer_analyze(&lexer_post_processor);
-    error_handler_report_errors(&lexer_post_processor.error_handler);
-
     /* Parser*/
-    parser_initialize_translation_unit(&translation_unit, lexer_post_processor);
+    parser_initialize_translation_unit(&translation_unit, &lexer_pre_processor);
     parse_translation_unit_content(&translation_unit);
     error_handler_report_errors(&translation_unit.error_handler);
 
     /* semantic analyzer  */
-    semantic_analyzer_initialize(&analyzer, &translation_unit, lexer_post_processor);
+    semantic_analyzer_initialize(&analyzer, &translation_unit, &lexer_pre_processor);
     semantic_analyzer_analyze_translation_unit(&analyzer,&translation_unit);
     error_handler_report_errors(&analyzer.error_handler);
 
-    code_generator_initialize(&generator,lexer_post_processor);
+    code_generator_initialize(&generator,&lexer_pre_processor);
     code_generator_update_labels(&generator,&translation_unit);
     generate_entry_file_string(&generator,&analyzer,&translation_unit);
     output_generate(&generator,&analyzer,&translation_unit,file_path);
@@ -57,7 +51,6 @@ int main() {
     code_generator_free(&generator);
     semantic_analyzer_free(&analyzer);
     parser_free_translation_unit(&translation_unit);
-    lexer_free(&lexer_post_processor);
     lexer_free(&lexer_pre_processor);
     preprocessor_free(&pre_processor);
 
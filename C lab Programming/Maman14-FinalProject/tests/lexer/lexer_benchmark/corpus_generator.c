@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Writes a synthetic .as file for the lexer benchmark.
+ * Every line is picked at random from a weighted mix of statement kinds, the generator is seeded with a constant
+ * so the same arguments always produce the same file (the corpus stays a fixed baseline between runs).
+ *
+ * usage: corpus_generator <file> <megabytes> [instructions labels data strings comments macros]
+ *        (file path without the .as extension, the six weights default to 40 15 15 10 15 5)
+ */
+
+#define MIX_SIZE 6
+#define MAX_MEGABYTES 1024
+#define MACRO_BODY_LINES 3
+
+typedef enum LineKind {
+    LINE_INSTRUCTION,
+    LINE_LABEL,
+    LINE_DATA,
+    LINE_STRING,
+    LINE_COMMENT,
+    LINE_MACRO
+} LineKind;
+
+static const char *two_operand_ops[] = {"mov", "cmp", "add", "sub", "lea"};
+static const char *one_operand_ops[] = {"clr", "not", "inc", "dec", "jmp", "bne", "red", "prn", "jsr"};
+static const char *words[] = {"alpha", "beta", "gamma", "delta", "buffer", "counter", "result", "value", "loop", "end"};
+
+static unsigned long random_state = 12345;
+
+static unsigned long next_random(unsigned long bound);
+static long write_operand(FILE *file, unsigned long labels, int is_destination);
+static long write_instruction(FILE *file, unsigned long labels);
+static long write_data(FILE *file);
+static long write_string(FILE *file);
+static long write_comment(FILE *file);
+static long write_macro(FILE *file, unsigned long *macros);
+
+int main(int argc, char *argv[]) {
+    char *path;
+    FILE *file;
+    long megabytes;
+    long target;
+    long written = 0;
+    unsigned long weights[MIX_SIZE] = {40, 15, 15, 10, 15, 5};
+    unsigned long total_weight = 0;
+    unsigned long labels = 0;
+    unsigned long macros = 0;
+    unsigned long pick;
+    int kind;
+    int i;
+
+    if ((argc != 3 && argc != 3 + MIX_SIZE) || (megabytes = atol(argv[2])) <= 0 || megabytes > MAX_MEGABYTES) {
+        printf("usage: %s <file> <megabytes (1 - %d)> [instructions labels data strings comments macros]\n",
+               argc > 0 ? argv[0] : "corpus_generator", MAX_MEGABYTES);
+        return 1;
+    }
+
+    if (argc == 3 + MIX_SIZE) {
+        for (i = 0; i < MIX_SIZE; i++) {
+            weights[i] = (unsigned long)atol(argv[3 + i]);
+        }
+    }
+    for (i = 0; i < MIX_SIZE; i++) {
+        total_weight += weights[i];
+    }
+    if (total_weight == 0) {
+        printf("at least one weight must be positive\n");
+        return 1;
+    }
+
+    path = malloc(strlen(argv[1]) + 4); /* +4 for ".as" and null terminator*/
+    if (path == NULL) {
+        return 1;
+    }
+    sprintf(path, "%s.as", argv[1]);
+
+    file = fopen(path, "w");
+    if (file == NULL) {
+        printf("Couldn't open \"%s\".\n", path);
+        free(path);
+        return 1;
+    }
+
+    target = megabytes * 1024 * 1024;
+    while (written < target) {
+        /* Pick the kind of the next line by its weight */
+        pick = next_random(total_weight);
+        for (kind = 0; pick >= weights[kind]; kind++) {
+            pick -= weights[kind];
+        }
+
+        switch ((LineKind)kind) {
+            case LINE_INSTRUCTION:
+                written += fprintf(file, "    ");
+                written += write_instruction(file, labels);
+                break;
+            case LINE_LABEL:
+                /* A label names the statement on its line, either an instruction or a .data list */
+                written += fprintf(file, "L%lu: ", labels++);
+                written += next_random(2) ? write_instruction(file, labels) : write_data(file);
+                break;
+            case LINE_DATA:
+                written += fprintf(file, "    ");
+                written += write_data(file);
+                break;
+            case LINE_STRING:
+                written += fprintf(file, "S%lu: ", labels++);
+                written += write_string(file);
+                break;
+            case LINE_COMMENT:
+                written += write_comment(file);
+                break;
+            case LINE_MACRO:
+                written += write_macro(file, &macros);
+                break;
+        }
+    }
+    written += fprintf(file, "    stop\n");
+    fclose(file);
+
+    printf("%s: %ld bytes, %lu labels, %lu macros\n", path, written, labels, macros);
+    free(path);
+    return 0;
+}
+
+/* A small linear congruential generator, rand() differs between C libraries and the corpus must not */
+static unsigned long next_random(unsigned long bound) {
+    random_state = (random_state * 1103515245UL + 12345UL) & 0x7FFFFFFFUL;
+    return (random_state >> 8) % bound;
+}
+
+/* Writes a register, an immediate, a dereferenced register or a reference to a label defined so far */
+static long write_operand(FILE *file, unsigned long labels, int is_destination) {
+    switch (next_random(is_destination ? 3 : 4)) {
+        case 0:
+            return fprintf(file, "r%lu", next_random(8));
+        case 1:
+            return fprintf(file, "*r%lu", next_random(8));
+        case 2:
+            if (labels > 0)
+                return fprintf(file, "L%lu", next_random(labels));
+            return fprintf(file, "r%lu", next_random(8));
+        default:
+            return fprintf(file, "#%ld", (long)next_random(2001) - 1000);
+    }
+}
+
+static long write_instruction(FILE *file, unsigned long labels) {
+    long written = 0;
+
+    switch (next_random(3)) {
+        case 0:
+            written += fprintf(file, "%s ", two_operand_ops[next_random(sizeof(two_operand_ops) / sizeof(two_operand_ops[0]))]);
+            written += write_operand(file, labels, 0);
+            written += fprintf(file, ", ");
+            written += write_operand(file, labels, 1);
+            break;
+        case 1:
+            written += fprintf(file, "%s ", one_operand_ops[next_random(sizeof(one_operand_ops) / sizeof(one_operand_ops[0]))]);
+            written += write_operand(file, labels, 1);
+            break;
+        default:
+            written += fprintf(file, "%s", next_random(2) ? "rts" : "stop");
+            break;
+    }
+
+    return written + fprintf(file, "\n");
+}
+
+static long write_data(FILE *file) {
+    long written = fprintf(file, ".data ");
+    unsigned long count = 1 + next_random(10);
+    unsigned long i;
+
+    for (i = 0; i < count; i++) {
+        written += fprintf(file, "%s%ld", i == 0 ? "" : ", ", (long)next_random(32768) - 16384);
+    }
+
+    return written + fprintf(file, "\n");
+}
+
+static long write_string(FILE *file) {
+    long written = fprintf(file, ".string \"");
+    unsigned long count = 1 + next_random(6);
+    unsigned long i;
+
+    for (i = 0; i < count; i++) {
+        written += fprintf(file, "%s%s", i == 0 ? "" : " ", words[next_random(sizeof(words) / sizeof(words[0]))]);
+    }
+
+    return written + fprintf(file, "\"\n");
+}
+
+static long write_comment(FILE *file) {
+    long written = fprintf(file, ";");
+    unsigned long count = 1 + next_random(10);
+    unsigned long i;
+
+    for (i = 0; i < count; i++) {
+        written += fprintf(file, " %s", words[next_random(sizeof(words) / sizeof(words[0]))]);
+    }
+
+    return written + fprintf(file, "\n");
+}
+
+/* Either defines a new macro or, once some exist, calls one of them */
+static long write_macro(FILE *file, unsigned long *macros) {
+    long written = 0;
+    int i;
+
+    if (*macros > 0 && next_random(2)) {
+        return fprintf(file, "    _m%lu\n", next_random(*macros));
+    }
+
+    written += fprintf(file, "macr _m%lu\n", (*macros)++);
+    for (i = 0; i < MACRO_BODY_LINES; i++) {
+        written += fprintf(file, "    ");
+        written += write_instruction(file, 0);
+    }
+    return written + fprintf(file, "endmacr\n");
+}
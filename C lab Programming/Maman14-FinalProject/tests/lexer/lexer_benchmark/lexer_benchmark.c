@@ -0,0 +1,120 @@
+#define _XOPEN_SOURCE 500 /* getrusage */
+#include "../../../headers/lexer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/*
+ * Measures the throughput of lexer_analyze over a corpus of .as files.
+ * Every file is read once, then lexed again and again from memory, only the time spent in lexer_analyze is counted.
+ * Allocations are counted by wrapping malloc, realloc and calloc at link time (see the Makefile), only the ones
+ * made inside lexer_analyze count. The peak RSS of the whole run is printed last.
+ *
+ * usage: lexer_benchmark <iterations> <file> [file ...]   (file paths without the .as extension)
+ */
+
+static void run_benchmark(char *file_path, long iterations, double *total_bytes, double *total_tokens, double *total_seconds,
+                          double *total_allocations);
+
+/* Allocation counting, the linker sends every malloc, realloc and calloc call through the wrappers below */
+void *__real_malloc(size_t size);
+void *__real_realloc(void *pointer, size_t size);
+void *__real_calloc(size_t count, size_t size);
+
+static int counting = 0;
+static unsigned long allocations = 0;
+
+void *__wrap_malloc(size_t size) {
+    allocations += counting;
+    return __real_malloc(size);
+}
+
+void *__wrap_realloc(void *pointer, size_t size) {
+    allocations += counting;
+    return __real_realloc(pointer, size);
+}
+
+void *__wrap_calloc(size_t count, size_t size) {
+    allocations += counting;
+    return __real_calloc(count, size);
+}
+
+int main(int argc, char *argv[]) {
+    long iterations;
+    double total_bytes = 0;
+    double total_tokens = 0;
+    double total_seconds = 0;
+    double total_allocations = 0;
+    struct rusage usage;
+    int i;
+
+    if (argc < 3 || (iterations = atol(argv[1])) <= 0) {
+        printf("usage: %s <iterations> <file> [file ...]\n", argc > 0 ? argv[0] : "lexer_benchmark");
+        return 1;
+    }
+
+    printf("%-32s %10s %10s %12s %14s %14s\n", "file", "bytes", "tokens", "MB/s", "tokens/s", "allocs/token");
+    for (i = 2; i < argc; i++) {
+        run_benchmark(argv[i], iterations, &total_bytes, &total_tokens, &total_seconds, &total_allocations);
+    }
+
+    if (total_seconds > 0) {
+        printf("%-32s %10.0f %10.0f %12.2f %14.0f %14.4f\n", "total",
+               total_bytes / iterations, total_tokens / iterations,
+               total_bytes / total_seconds / 1e6, total_tokens / total_seconds,
+               total_tokens > 0 ? total_allocations / total_tokens : 0.0);
+    }
+
+    /* ru_maxrss is in kilobytes on Linux */
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        printf("peak RSS: %ld KB\n", usage.ru_maxrss);
+    }
+
+    return 0;
+}
+
+static void run_benchmark(char *file_path, long iterations, double *total_bytes, double *total_tokens, double *total_seconds,
+                          double *total_allocations) {
+    Lexer source;
+    Lexer lexer;
+    unsigned int tokens = 0;
+    clock_t ticks = 0;
+    clock_t start;
+    double seconds;
+    long i;
+
+    if (!lexer_initialize_from_file(&source, file_path)) {
+        lexer_free(&source);
+        return;
+    }
+
+    for (i = 0; i < iterations; i++) {
+        lexer_initialize_from_string(&lexer, source.file_path, source.source_code);
+
+        counting = 1;
+        start = clock();
+        lexer_analyze(&lexer);
+        ticks += clock() - start;
+        counting = 0;
+
+        tokens = lexer.tokens.count;
+        error_handler_free(&lexer.error_handler);
+        lexer_free(&lexer);
+    }
+
+    seconds = (double)ticks / CLOCKS_PER_SEC;
+    printf("%-32s %10u %10u %12.2f %14.0f %14.4f\n", file_path, source.source_code.length, tokens,
+           seconds > 0 ? (double)source.source_code.length * iterations / seconds / 1e6 : 0.0,
+           seconds > 0 ? (double)tokens * iterations / seconds : 0.0,
+           tokens > 0 ? (double)allocations / ((double)tokens * iterations) : 0.0);
+
+    *total_bytes += (double)source.source_code.length * iterations;
+    *total_tokens += (double)tokens * iterations;
+    *total_seconds += seconds;
+    *total_allocations += allocations;
+    allocations = 0;
+
+    error_handler_free(&source.error_handler);
+    lexer_free(&source);
+}
@@ -0,0 +1,108 @@
+#include <string.h>
+#include "../../../headers/lexer.h"
+
+/* Lexes a file in 1 to 16 chunks and checks the tokens, line starts and errors against lexer_analyze */
+
+#define MAX_CHUNKS 16
+
+void run_test(char *file_path);
+unsigned int compare_lexers(Lexer *expected, Lexer *chunked);
+unsigned int compare_errors(ErrorNode *expected, ErrorNode *chunked);
+
+int main() {
+    printf("Running test 1:\n");
+    run_test("../../TheTest/fibo_test");
+
+    printf("\nRunning test 2:\n");
+    run_test("../../TheTest/function_call_string_mani");
+
+    printf("\nRunning test 3 (with errors, strings run over the cuts):\n");
+    run_test("test1");
+
+    return 0;
+}
+
+void run_test(char *file_path) {
+    Lexer expected;
+    Lexer chunked;
+    unsigned int chunk_count;
+    unsigned int mismatches;
+
+    lexer_initialize_from_file(&expected, file_path);
+    lexer_analyze(&expected);
+    printf("%s: %u tokens, %u lines\n", expected.file_path, expected.tokens.count, expected.line_index.count);
+
+    for (chunk_count = 1; chunk_count <= MAX_CHUNKS; chunk_count++) {
+        lexer_initialize_from_file(&chunked, file_path);
+        lexer_analyze_chunks(&chunked, chunk_count);
+
+        mismatches = compare_lexers(&expected, &chunked);
+        printf("%2u chunks: %u tokens, %u differ\n", chunk_count, chunked.tokens.count, mismatches);
+
+        error_handler_free(&chunked.error_handler);
+        lexer_free(&chunked);
+    }
+
+    error_handler_report_errors(&expected.error_handler);
+    error_handler_free(&expected.error_handler);
+    lexer_free(&expected);
+}
+
+unsigned int compare_lexers(Lexer *expected, Lexer *chunked) {
+    unsigned int mismatches = 0;
+    unsigned int i;
+
+    if (chunked->tokens.count != expected->tokens.count) {
+        printf("Token count %u, expected %u\n", chunked->tokens.count, expected->tokens.count);
+        mismatches++;
+    }
+    for (i = 0; i < chunked->tokens.count && i < expected->tokens.count; i++) {
+        if (memcmp(&chunked->tokens.data[i], &expected->tokens.data[i], sizeof(Token)) != 0) {
+            printf("Token %u differs: %.*s, expected %.*s\n", i,
+                   (int)chunked->tokens.data[i].length, token_text(chunked->tokens.data[i], chunked->source_code),
+                   (int)expected->tokens.data[i].length, token_text(expected->tokens.data[i], expected->source_code));
+            mismatches++;
+        }
+    }
+
+    if (chunked->line_index.count != expected->line_index.count ||
+        memcmp(chunked->line_index.starts, expected->line_index.starts, expected->line_index.count * sizeof(unsigned int)) != 0) {
+        printf("Line starts differ (%u lines, expected %u)\n", chunked->line_index.count, expected->line_index.count);
+        mismatches++;
+    }
+
+    if (chunked->line_number != expected->line_number || chunked->macro_count != expected->macro_count) {
+        printf("Ended on line %u with %u macros, expected line %u with %u macros\n",
+               chunked->line_number, chunked->macro_count, expected->line_number, expected->macro_count);
+        mismatches++;
+    }
+
+    return mismatches + compare_errors(expected->error_handler.error_list, chunked->error_handler.error_list);
+}
+
+unsigned int compare_errors(ErrorNode *expected, ErrorNode *chunked) {
+    unsigned int mismatches = 0;
+
+    while (expected != NULL && chunked != NULL) {
+        if (chunked->type != expected->type ||
+            (chunked->type == TOKEN_ERROR_TYPE &&
+             (memcmp(&chunked->error.tokenError.token, &expected->error.tokenError.token, sizeof(Token)) != 0 ||
+              strcmp(chunked->error.tokenError.message.data, expected->error.tokenError.message.data) != 0)) ||
+            (chunked->type == CHAR_ERROR_TYPE &&
+             (chunked->error.charError.fileIndex != expected->error.charError.fileIndex ||
+              chunked->error.charError.lineNumber != expected->error.charError.lineNumber ||
+              chunked->error.charError.lineIndex != expected->error.charError.lineIndex ||
+              strcmp(chunked->error.charError.message.data, expected->error.charError.message.data) != 0))) {
+            printf("An error differs from the one expected\n");
+            mismatches++;
+        }
+        expected = expected->next;
+        chunked = chunked->next;
+    }
+
+    if (expected != NULL || chunked != NULL) {
+        printf("The error lists have different lengths\n");
+        mismatches++;
+    }
+    return mismatches;
+}
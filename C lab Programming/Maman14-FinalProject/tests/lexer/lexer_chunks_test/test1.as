@@ -0,0 +1,22 @@
+; a comment with a " quote in it, the chunk after it must not start a string
+MAIN: mov r3, LIST
+STR: .string "a string that runs
+over three
+lines"
+LIST: .data 6, -9, +15
+     - add r3, LIST
+.unknown r1
+@
+macr _m1
+  inc r2
+endmacr
+  _m1
+S2: .string "another ; string that
+  holds a comment char"
+; "
+  jmp MAIN
+  cmp #-5, *r4
+$
+.data 1, 2
+"unclosed
+stop
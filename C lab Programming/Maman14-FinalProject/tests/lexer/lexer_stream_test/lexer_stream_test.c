@@ -0,0 +1,68 @@
+#include <string.h>
+#include "../../../headers/lexer.h"
+
+/* Streams a file through rings of different sizes and checks every token against lexer_analyze */
+
+void run_test(char *file_path, unsigned long capacity);
+
+int main() {
+    printf("Running test 1 (smallest ring, tokens wrap around it):\n");
+    run_test("../../TheTest/fibo_test", 16);
+
+    printf("\nRunning test 2:\n");
+    run_test("../../TheTest/function_call_string_mani", 64);
+
+    printf("\nRunning test 3 (whole file fits in the ring):\n");
+    run_test("../../TheTest/function_call_string_mani", 65536);
+
+    printf("\nRunning test 4 (with errors, the string is longer than the ring):\n");
+    run_test("test1", 16);
+
+    printf("\nRunning test 5 (with errors):\n");
+    run_test("test1", 128);
+
+    return 0;
+}
+
+void run_test(char *file_path, unsigned long capacity) {
+    Lexer lexer;
+    LexerStream stream;
+    Token token;
+    Token expected;
+    unsigned int expected_line;
+    unsigned int expected_column;
+    unsigned int count = 0;
+    unsigned int mismatches = 0;
+
+    lexer_initialize_from_file(&lexer, file_path);
+    lexer_analyze(&lexer);
+
+    lexer_stream_open(&stream, file_path, capacity);
+    printf("Streaming %s through a %lu byte ring\n", stream.file_path, stream.capacity);
+
+    while (lexer_stream_next(&stream, &token)) {
+        if (count >= lexer.tokens.count) {
+            printf("Extra token at line %u, column %u\n", stream.token_line, stream.token_column);
+            mismatches++;
+        } else {
+            expected = lexer.tokens.data[count];
+            expected_line = line_index_find_line(lexer.line_index, expected.index);
+            expected_column = line_index_find_column(lexer.line_index, expected.index);
+            if (token.type != expected.type || token.index != expected.index || stream.token_line != expected_line ||
+                stream.token_column != expected_column || token.length != expected.length || token.value != expected.value ||
+                memcmp(lexer_stream_token_text(&stream, token), token_text(expected, lexer.source_code), token.length) != 0) {
+                printf("Token %u differs: streamed %.*s (line %u, column %u), expected %.*s (line %u, column %u)\n", count,
+                       (int)token.length, lexer_stream_token_text(&stream, token), stream.token_line, stream.token_column,
+                       (int)expected.length, token_text(expected, lexer.source_code), expected_line, expected_column);
+                mismatches++;
+            }
+        }
+        count++;
+    }
+
+    printf("Streamed %u tokens (lexer_analyze produced %u), %u differ\n", count, lexer.tokens.count, mismatches);
+    error_handler_report_errors(&stream.error_handler);
+
+    lexer_stream_close(&stream);
+    lexer_free(&lexer);
+}
@@ -0,0 +1,11 @@
+; a comment that is much longer than the smallest ring the stream can use
+STR: .string "a string that runs past sixteen bytes"
+LIST: .data 6, -9, +15
+     - add r3, LIST
+.unknown r1
+@
+macr _m1
+  inc r2
+endmacr
+"unclosed
+stop
\ No newline at end of file
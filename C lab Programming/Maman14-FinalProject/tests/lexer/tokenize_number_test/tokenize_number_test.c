@@ -27,6 +27,7 @@ void run_test(const char* test_input) {
 int main() {
     const char* test_input1 = "+\n-8856\n772\n+1246\n-";
     const char* test_input2 = "-7656\n8852\n+3546";
+    const char* test_input3 = "2147483647\n2147483648\n-2147483648\n-99999999999";
 
     printf("Running test 1 with errors:\n");
     run_test(test_input1);
@@ -34,5 +35,8 @@ int main() {
     printf("\nRunning test 2:\n");
     run_test(test_input2);
 
+    printf("\nRunning test 3 with overflow:\n");
+    run_test(test_input3);
+
     return 0;
 }
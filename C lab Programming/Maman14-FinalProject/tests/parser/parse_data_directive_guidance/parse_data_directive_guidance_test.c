@@ -6,11 +6,10 @@
 
 void run_test(char* file_path) {
     Lexer lexer_preprocess;
-    Lexer lexer_postprocess;
     Preprocessor preprocessor;
     TranslationUnit unit;
     DataNode data_node;
-    TokenReferenceNode *list = NULL;
+    unsigned int index;
 
     /* preprocess lexer  */
     lexer_initialize_from_file(&lexer_preprocess, file_path);
@@ -18,30 +17,22 @@ void run_test(char* file_path) {
     error_handler_report_errors(&lexer_preprocess.error_handler);
 
     /* preprocesser */
-    preprocessor_initialize(&preprocessor, lexer_preprocess, file_path);
+    preprocessor_initialize(&preprocessor, &lexer_preprocess, file_path);
     preprocessor_process(&preprocessor, lexer_preprocess.source_code);
     error_handler_report_errors(&preprocessor.error_handler);
 
-    /* postprocess lexer */
-    lexer_initialize_from_string(&lexer_postprocess, preprocessor.error_handler.file_path, preprocessor.processed_source);
-    lexer_analyze(&lexer_postprocess);
-    error_handler_report_errors(&lexer_postprocess.error_handler);
-
     /* parser pass */
-    parser_initialize_translation_unit(&unit, lexer_postprocess);
+    parser_initialize_translation_unit(&unit, &lexer_preprocess);
     data_node = parse_data_directive_guidance(&unit);
-    list = data_node.data_numbers;
     error_handler_report_errors(&unit.error_handler);
 
-    while (list != NULL) {
-        printf("%d, ", atoi(list->token->string.data));
-        list = list->next;
+    for (index = 0; index < data_node.count; index++) {
+        printf("%d, ", data_node.numbers[index]);
     }
     printf("\n");
 
     parser_free_directive_guidance(data_node);
     lexer_free(&lexer_preprocess);
-    lexer_free(&lexer_postprocess);
     preprocessor_free(&preprocessor);
     parser_free_translation_unit(&unit);
 }
@@ -0,0 +1,193 @@
+#include <string.h>
+#include "../../../headers/lexer.h"
+#include "../../../headers/preprocessor.h"
+#include "../../../headers/parser.h"
+
+/* Parses a file in 1 to 16 ranges and checks the lists, instruction rows and errors against parse_translation_unit_content */
+
+#define MAX_RANGES 16
+
+void run_test(char *file_path);
+unsigned int compare_units(TranslationUnit *expected, TranslationUnit *ranged);
+unsigned int compare_labels(LabelNodeList *expected, LabelNodeList *ranged);
+unsigned int compare_errors(ErrorNode *expected, ErrorNode *ranged);
+
+int main() {
+    printf("Running test 1:\n");
+    run_test("../../TheTest/fibo_test");
+
+    printf("\nRunning test 2:\n");
+    run_test("../../TheTest/function_call_string_mani");
+
+    printf("\nRunning test 3 (with errors, labels that take a statement a few lines down):\n");
+    run_test("test1");
+
+    return 0;
+}
+
+void run_test(char *file_path) {
+    Lexer lexer;
+    Preprocessor preprocessor;
+    TranslationUnit expected;
+    TranslationUnit ranged;
+    unsigned int range_count;
+    unsigned int mismatches;
+
+    lexer_initialize_from_file(&lexer, file_path);
+    lexer_analyze(&lexer);
+    preprocessor_initialize(&preprocessor, &lexer, file_path);
+    preprocessor_process(&preprocessor, lexer.source_code);
+
+    parser_initialize_translation_unit(&expected, &lexer);
+    parse_translation_unit_content(&expected);
+    printf("%s: %u tokens, %u instructions\n", file_path, expected.tokens.count, expected.instructions.count);
+
+    for (range_count = 1; range_count <= MAX_RANGES; range_count++) {
+        parser_initialize_translation_unit(&ranged, &lexer);
+        parser_parse_ranges(&ranged, range_count);
+
+        mismatches = compare_units(&expected, &ranged);
+        printf("%2u ranges: %u instructions, %u differ\n", range_count, ranged.instructions.count, mismatches);
+
+        parser_free_translation_unit(&ranged);
+    }
+
+    error_handler_report_errors(&expected.error_handler);
+    parser_free_translation_unit(&expected);
+    preprocessor_free(&preprocessor);
+    lexer_free(&lexer);
+}
+
+unsigned int compare_units(TranslationUnit *expected, TranslationUnit *ranged) {
+    unsigned int mismatches = 0;
+    ExternalNodeList *expected_external = expected->external_list;
+    ExternalNodeList *ranged_external = ranged->external_list;
+    EntryNodeList *expected_entry = expected->entry_list;
+    EntryNodeList *ranged_entry = ranged->entry_list;
+    InstructionTable *table = &expected->instructions;
+    InstructionTable *ranged_table = &ranged->instructions;
+    unsigned int row;
+
+    while (expected_external != NULL && ranged_external != NULL) {
+        if (ranged_external->external_node.external_label != expected_external->external_node.external_label ||
+            ranged_external->external_node.has_parser_error != expected_external->external_node.has_parser_error) {
+            printf("An .extern differs from the one expected\n");
+            mismatches++;
+        }
+        expected_external = expected_external->next;
+        ranged_external = ranged_external->next;
+    }
+    while (expected_entry != NULL && ranged_entry != NULL) {
+        if (ranged_entry->entry_node.entry_label != expected_entry->entry_node.entry_label ||
+            ranged_entry->entry_node.has_parser_error != expected_entry->entry_node.has_parser_error) {
+            printf("An .entry differs from the one expected\n");
+            mismatches++;
+        }
+        expected_entry = expected_entry->next;
+        ranged_entry = ranged_entry->next;
+    }
+    if (expected_external != NULL || ranged_external != NULL || expected_entry != NULL || ranged_entry != NULL) {
+        printf("The .extern or .entry lists have different lengths\n");
+        mismatches++;
+    }
+
+    mismatches += compare_labels(expected->instruction_label_list, ranged->instruction_label_list);
+    mismatches += compare_labels(expected->guidance_label_list, ranged->guidance_label_list);
+
+    if (ranged_table->count != table->count) {
+        printf("Instruction count %u, expected %u\n", ranged_table->count, table->count);
+        mismatches++;
+    }
+    for (row = 0; row < ranged_table->count && row < table->count; row++) {
+        if (ranged_table->opcode[row] != table->opcode[row] ||
+            ranged_table->source_mode[row] != table->source_mode[row] ||
+            ranged_table->destination_mode[row] != table->destination_mode[row] ||
+            ranged_table->flags[row] != table->flags[row] ||
+            ranged_table->source_value[row] != table->source_value[row] ||
+            ranged_table->destination_value[row] != table->destination_value[row] ||
+            ranged_table->token[row] != table->token[row] ||
+            ranged_table->source_token[row] != table->source_token[row] ||
+            ranged_table->destination_token[row] != table->destination_token[row]) {
+            printf("Instruction row %u differs\n", row);
+            mismatches++;
+        }
+    }
+
+    if (ranged->current != expected->current) {
+        printf("Stopped on token %u, expected %u\n", ranged->current, expected->current);
+        mismatches++;
+    }
+
+    return mismatches + compare_errors(expected->error_handler.error_list, ranged->error_handler.error_list);
+}
+
+unsigned int compare_labels(LabelNodeList *expected, LabelNodeList *ranged) {
+    unsigned int mismatches = 0;
+    GuidanceNodeList *expected_guidance;
+    GuidanceNodeList *ranged_guidance;
+
+    while (expected != NULL && ranged != NULL) {
+        if (ranged->label.label != expected->label.label ||
+            ranged->label.first_instruction != expected->label.first_instruction ||
+            ranged->label.instruction_count != expected->label.instruction_count) {
+            printf("A label differs from the one expected\n");
+            mismatches++;
+        }
+
+        expected_guidance = expected->label.guidance_list;
+        ranged_guidance = ranged->label.guidance_list;
+        while (expected_guidance != NULL && ranged_guidance != NULL) {
+            if (ranged_guidance->type != expected_guidance->type ||
+                (ranged_guidance->type == DATA_NODE &&
+                 (ranged_guidance->node.dataNode.count != expected_guidance->node.dataNode.count ||
+                  ranged_guidance->node.dataNode.first_number != expected_guidance->node.dataNode.first_number ||
+                  ranged_guidance->node.dataNode.is_out_of_range != expected_guidance->node.dataNode.is_out_of_range ||
+                  ranged_guidance->node.dataNode.has_parser_error != expected_guidance->node.dataNode.has_parser_error ||
+                  memcmp(ranged_guidance->node.dataNode.numbers, expected_guidance->node.dataNode.numbers,
+                         expected_guidance->node.dataNode.count * sizeof(short)) != 0)) ||
+                (ranged_guidance->type == STRING_NODE &&
+                 (ranged_guidance->node.stringNode.string_label != expected_guidance->node.stringNode.string_label ||
+                  ranged_guidance->node.stringNode.has_parser_error != expected_guidance->node.stringNode.has_parser_error))) {
+                printf("A guidance differs from the one expected\n");
+                mismatches++;
+            }
+            expected_guidance = expected_guidance->next;
+            ranged_guidance = ranged_guidance->next;
+        }
+
+        if (expected_guidance != NULL || ranged_guidance != NULL) {
+            printf("A label's guidance lists have different lengths\n");
+            mismatches++;
+        }
+        expected = expected->next;
+        ranged = ranged->next;
+    }
+
+    if (expected != NULL || ranged != NULL) {
+        printf("The label lists have different lengths\n");
+        mismatches++;
+    }
+    return mismatches;
+}
+
+unsigned int compare_errors(ErrorNode *expected, ErrorNode *ranged) {
+    unsigned int mismatches = 0;
+
+    while (expected != NULL && ranged != NULL) {
+        if (ranged->type != expected->type ||
+            (ranged->type == TOKEN_ERROR_TYPE &&
+             (memcmp(&ranged->error.tokenError.token, &expected->error.tokenError.token, sizeof(Token)) != 0 ||
+              strcmp(ranged->error.tokenError.message.data, expected->error.tokenError.message.data) != 0))) {
+            printf("An error differs from the one expected\n");
+            mismatches++;
+        }
+        expected = expected->next;
+        ranged = ranged->next;
+    }
+
+    if (expected != NULL || ranged != NULL) {
+        printf("The error lists have different lengths\n");
+        mismatches++;
+    }
+    return mismatches;
+}
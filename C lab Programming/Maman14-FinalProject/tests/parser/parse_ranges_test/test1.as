@@ -0,0 +1,27 @@
+; statements with errors, labels whose statement is a few lines down and directives between them
+.extern EXT
+MAIN: mov r3, LIST
+LOOP:
+
+      add #5, *r2
+      jmp EXT
+END: stop
+LIST: .data 6, -9, +15
+      .data 40000
+STR: .string "abcd"
+.entry MAIN
+.entry
+BAD mov r1, r2
+X: .string
+.extern A B
+Y: cmp #-5, *r4
+   prn #
+   red r7
+EMPTY:
+
+
+Z: .data 1, 2,
+.entry LOOP
+K: lea STR, r6
+   inc
+   rts
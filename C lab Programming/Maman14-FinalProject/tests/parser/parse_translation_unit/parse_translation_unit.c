@@ -4,28 +4,27 @@
 #include "../../../headers/parser.h"
 #include "../../../headers/string_util.h"
 
-static void print_label(LabelNode label) {
+static void print_operand(const char *name, Token *operand, bool is_dereferenced, String source) {
+    printf("    %s: %.*s\n", name, (int)operand->length, token_text(*operand, source));
+    if (is_dereferenced) {
+        printf("    (Dereferenced)\n");
+    }
+}
 
-    InstructionNodeList *current;
-    TokenReferenceNode *data;
-	
-    if (label.instruction_list != NULL) {
-        current = label.instruction_list;
-        while (current != NULL) {
-            printf("  Instruction: %s\n", current->node.operation->string.data);
-            if (current->node.first_operand != NULL) {
-                printf("    Operand1: %s\n", current->node.first_operand->string.data);
-                if (current->node.is_first_operand_derefrenced) {
-                    printf("    (Dereferenced)\n");
-                }
-            }
-            if (current->node.second_operand != NULL) {
-                printf("    Operand2: %s\n", current->node.second_operand->string.data);
-                if (current->node.is_second_operand_derefrenced) {
-                    printf("    (Dereferenced)\n");
-                }
-            }
-            current = current->next;
+static void print_label(LabelNode label, TranslationUnit *unit, String source) {
+    InstructionTable *table = &unit->instructions;
+    Token *tokens = unit->tokens.data;
+    unsigned int row;
+    unsigned int index;
+
+    /* A lone operand sits in the destination columns, it is still printed as the first one */
+    for (row = label.first_instruction; row < label.first_instruction + label.instruction_count; row++) {
+        printf("  Instruction: %.*s\n", (int)tokens[table->token[row]].length, token_text(tokens[table->token[row]], source));
+        if (table->source_mode[row] != 0) {
+            print_operand("Operand1", &tokens[table->source_token[row]], (table->flags[row] & INSTRUCTION_SOURCE_DEREFERENCED) != 0, source);
+            print_operand("Operand2", &tokens[table->destination_token[row]], (table->flags[row] & INSTRUCTION_DESTINATION_DEREFERENCED) != 0, source);
+        } else if (table->destination_mode[row] != 0) {
+            print_operand("Operand1", &tokens[table->destination_token[row]], (table->flags[row] & INSTRUCTION_DESTINATION_DEREFERENCED) != 0, source);
         }
     }
 
@@ -34,14 +33,12 @@ static void print_label(LabelNode label) {
         while (current != NULL) {
             if (current->type == DATA_NODE) {
                 printf("  Data: ");
-                data = current->node.dataNode.data_numbers;
-                while (data != NULL) {
-                    printf("%s ", data->token->string.data);
-                    data = data->next;
+                for (index = 0; index < current->node.dataNode.count; index++) {
+                    printf("%d ", current->node.dataNode.numbers[index]);
                 }
                 printf("\n");
             } else if (current->type == STRING_NODE) {
-                printf("  String: %s\n", current->node.stringNode.string_label->string.data);
+                printf("  String: %.*s\n", (int)current->node.stringNode.string_label->length, token_text(*current->node.stringNode.string_label, source));
             }
             current = current->next;
         }
@@ -50,7 +47,6 @@ static void print_label(LabelNode label) {
 
 void process_file(char* file_path) {
     Lexer lexer_preprocess;
-    Lexer lexer_postprocess;
     Preprocessor preprocessor;
     TranslationUnit unit;
     ExternalNodeList *external_node_list = NULL;
@@ -64,15 +60,11 @@ void process_file(char* file_path) {
     lexer_analyze(&lexer_preprocess);
     error_handler_report_errors(&lexer_preprocess.error_handler);
 
-    preprocessor_initialize(&preprocessor, lexer_preprocess, file_path);
+    preprocessor_initialize(&preprocessor, &lexer_preprocess, file_path);
     preprocessor_process(&preprocessor, lexer_preprocess.source_code);
     error_handler_report_errors(&preprocessor.error_handler);
 
-    lexer_initialize_from_string(&lexer_postprocess, preprocessor.error_handler.file_path, preprocessor.processed_source);
-    lexer_analyze(&lexer_postprocess);
-    error_handler_report_errors(&lexer_postprocess.error_handler);
-
-    parser_initialize_translation_unit(&unit, lexer_postprocess);
+    parser_initialize_translation_unit(&unit, &lexer_preprocess);
     parse_translation_unit_content(&unit);
     error_handler_report_errors(&unit.error_handler);
 
@@ -83,30 +75,29 @@ void process_file(char* file_path) {
 
     printf("Extern declarations:\n");
     while (external_node_list != NULL) {
-        printf(".extern %s\n", external_node_list->external_node.external_label->string.data);
+        printf(".extern %.*s\n", (int)external_node_list->external_node.external_label->length, token_text(*external_node_list->external_node.external_label, lexer_preprocess.source_code));
         external_node_list = external_node_list->next;
     }
 
     printf("\nEntry declarations:\n");
     while (entry_node_list != NULL) {
-        printf(".entry %s\n", entry_node_list->entry_node.entry_label->string.data);
+        printf(".entry %.*s\n", (int)entry_node_list->entry_node.entry_label->length, token_text(*entry_node_list->entry_node.entry_label, lexer_preprocess.source_code));
         entry_node_list = entry_node_list->next;
     }
 
     printf("\nInstruction labels:\n");
     while (instruction_label_list != NULL) {
-        print_label(instruction_label_list->label);
+        print_label(instruction_label_list->label, &unit, lexer_preprocess.source_code);
         instruction_label_list = instruction_label_list->next;
     }
 
     printf("\nGuidance labels:\n");
     while (guidance_label_list != NULL) {
-        print_label(guidance_label_list->label);
+        print_label(guidance_label_list->label, &unit, lexer_preprocess.source_code);
         guidance_label_list = guidance_label_list->next;
     }
 
     lexer_free(&lexer_preprocess);
-    lexer_free(&lexer_postprocess);
     preprocessor_free(&preprocessor);
     parser_free_translation_unit(&unit);
 
@@ -6,12 +6,11 @@
 
 int main(){
     Lexer lexer_preprocess;
-    Lexer lexer_postprocess;
     Preprocessor preprocessor;
     TranslationUnit unit;
     GuidanceNodeList * guidance_list;
     GuidanceNodeList * c;
-    TokenReferenceNode * list = NULL;
+    unsigned int index;
 
     char* file_path = "test1";
 
@@ -21,17 +20,12 @@ int main(){
     error_handler_report_errors(&lexer_preprocess.error_handler);
 
     /* preprocesser */
-    preprocessor_initialize(&preprocessor, lexer_preprocess,file_path);
+    preprocessor_initialize(&preprocessor, &lexer_preprocess,file_path);
     preprocessor_process(&preprocessor, lexer_preprocess.source_code);
     error_handler_report_errors(&preprocessor.error_handler);
 
-    /* postprocess lexer */
-    lexer_initialize_from_string(&lexer_postprocess, preprocessor.error_handler.file_path, preprocessor.processed_source);
-    lexer_analyze(&lexer_postprocess);
-    error_handler_report_errors(&lexer_postprocess.error_handler);
-
     /* parser */
-    parser_initialize_translation_unit(&unit, lexer_postprocess);
+    parser_initialize_translation_unit(&unit, &lexer_preprocess);
     guidance_list = parser_parse_guidance_list(&unit);
     c = guidance_list;
     error_handler_report_errors(&unit.error_handler);
@@ -40,16 +34,13 @@ int main(){
         if (guidance_list->type == DATA_NODE){
             printf(".data ");
 
-            list = guidance_list->node.dataNode.data_numbers;
-
-            while (list != NULL){
-                printf("%d, ", atoi(list->token->string.data));
-                list = list->next;
+            for (index = 0; index < guidance_list->node.dataNode.count; index++){
+                printf("%d, ", guidance_list->node.dataNode.numbers[index]);
             }
             printf("\n");
         } else if (guidance_list->type == STRING_NODE){
             if (guidance_list->node.stringNode.string_label != NULL)
-                printf(".string %s\n", guidance_list->node.stringNode.string_label->string.data);
+                printf(".string %.*s\n", (int)guidance_list->node.stringNode.string_label->length, token_text(*guidance_list->node.stringNode.string_label, lexer_preprocess.source_code));
         }
 
         guidance_list = guidance_list->next;
@@ -58,7 +49,6 @@ int main(){
 
 
     lexer_free(&lexer_preprocess);
-    lexer_free(&lexer_postprocess);
     preprocessor_free(&preprocessor);
     parser_free_guidance_list(c);
     parser_free_translation_unit(&unit);
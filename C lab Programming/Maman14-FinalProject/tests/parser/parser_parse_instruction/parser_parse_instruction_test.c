@@ -6,7 +6,6 @@
 
 void run_test(char* file_path) {
     Lexer lexer_preprocess;
-    Lexer lexer_postprocess;
     Preprocessor preprocessor;
     TranslationUnit unit;
     InstructionNode instruction_node;
@@ -17,28 +16,22 @@ void run_test(char* file_path) {
     error_handler_report_errors(&lexer_preprocess.error_handler);
 
     /* preprocesser  */
-    preprocessor_initialize(&preprocessor, lexer_preprocess, file_path);
+    preprocessor_initialize(&preprocessor, &lexer_preprocess, file_path);
     preprocessor_process(&preprocessor, lexer_preprocess.source_code);
     error_handler_report_errors(&preprocessor.error_handler);
 
-    /* postprocess lexer  */
-    lexer_initialize_from_string(&lexer_postprocess, preprocessor.error_handler.file_path, preprocessor.processed_source);
-    lexer_analyze(&lexer_postprocess);
-    error_handler_report_errors(&lexer_postprocess.error_handler);
-
     /* parser  */
-    parser_initialize_translation_unit(&unit, lexer_postprocess);
+    parser_initialize_translation_unit(&unit, &lexer_preprocess);
     instruction_node = parser_parse_instruction(&unit);
     error_handler_report_errors(&unit.error_handler);
 
     if (instruction_node.first_operand != NULL)
-        printf("first operand: %s\n", instruction_node.first_operand->string.data);
+        printf("first operand: %.*s\n", (int)instruction_node.first_operand->length, token_text(*instruction_node.first_operand, lexer_preprocess.source_code));
 
     if (instruction_node.second_operand != NULL)
-        printf("second operand: %s\n", instruction_node.second_operand->string.data);
+        printf("second operand: %.*s\n", (int)instruction_node.second_operand->length, token_text(*instruction_node.second_operand, lexer_preprocess.source_code));
 
     lexer_free(&lexer_preprocess);
-    lexer_free(&lexer_postprocess);
     preprocessor_free(&preprocessor);
     parser_free_translation_unit(&unit);
 }
@@ -6,7 +6,6 @@
 
 int main(){
     Lexer lexer_preprocess;
-    Lexer lexer_postprocess;
     Preprocessor preprocessor;
     TranslationUnit unit;
     InstructionNodeList * instruction_list;
@@ -20,35 +19,29 @@ int main(){
     error_handler_report_errors(&lexer_preprocess.error_handler);
 
     /* preprocesser  */
-    preprocessor_initialize(&preprocessor, lexer_preprocess,file_path);
+    preprocessor_initialize(&preprocessor, &lexer_preprocess,file_path);
     preprocessor_process(&preprocessor, lexer_preprocess.source_code);
     error_handler_report_errors(&preprocessor.error_handler);
 
-    /* postprocess lexer  */
-    lexer_initialize_from_string(&lexer_postprocess, preprocessor.error_handler.file_path, preprocessor.processed_source);
-    lexer_analyze(&lexer_postprocess);
-    error_handler_report_errors(&lexer_postprocess.error_handler);
-
     /* parser  */
-    parser_initialize_translation_unit(&unit, lexer_postprocess);
+    parser_initialize_translation_unit(&unit, &lexer_preprocess);
     instruction_list = parser_parse_instruction_list(&unit);
     temp = instruction_list;
     error_handler_report_errors(&unit.error_handler);
 
     while (instruction_list){
-        printf("operation: %s\n", instruction_list->node.operation->string.data);
+        printf("operation: %.*s\n", (int)instruction_list->node.operation->length, token_text(*instruction_list->node.operation, lexer_preprocess.source_code));
 
         if (instruction_list->node.first_operand != NULL)
-            printf("first operand: %s\n", instruction_list->node.first_operand->string.data);
+            printf("first operand: %.*s\n", (int)instruction_list->node.first_operand->length, token_text(*instruction_list->node.first_operand, lexer_preprocess.source_code));
 
         if (instruction_list->node.second_operand != NULL)
-            printf("second operand: %s\n", instruction_list->node.second_operand->string.data);
+            printf("second operand: %.*s\n", (int)instruction_list->node.second_operand->length, token_text(*instruction_list->node.second_operand, lexer_preprocess.source_code));
 
         instruction_list = instruction_list->next;
     }
 
     lexer_free(&lexer_preprocess);
-    lexer_free(&lexer_postprocess);
     preprocessor_free(&preprocessor);
     parser_free_instruction_list(temp);
     parser_free_translation_unit(&unit);
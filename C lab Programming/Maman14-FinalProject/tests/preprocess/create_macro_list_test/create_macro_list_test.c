@@ -12,7 +12,7 @@ void run_test(char* file_path) {
     lexer_print_token_list(&lexer);
     error_handler_report_errors(&lexer.error_handler);
 
-    preprocessor_initialize(&pre_processor,lexer,file_path);
+    preprocessor_initialize(&pre_processor,&lexer,file_path);
     preprocessor_create_macro_list(&pre_processor,lexer.source_code);
     error_handler_report_errors(&pre_processor.error_handler);
 
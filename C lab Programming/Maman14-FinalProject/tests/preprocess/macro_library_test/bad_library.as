@@ -0,0 +1,4 @@
+macr OK
+    prn r1
+endmacr
+mov r1, r2
@@ -0,0 +1,72 @@
+#include <string.h>
+#include "../../../headers/lexer.h"
+#include "../../../headers/preprocessor.h"
+
+/* Preprocesses a file that includes a macro library twice, the first run builds the library's image (utils.amc)
+ * and the second maps it in, both must expand to the same token stream */
+
+unsigned int run_test(char *file_path, Lexer *lexer);
+unsigned int compare_streams(Lexer *built, Lexer *mapped);
+
+int main() {
+    Lexer built;
+    Lexer mapped;
+
+    remove("utils.amc");
+
+    printf("Running test 1 (the library image is built):\n");
+    run_test("test1", &built);
+
+    printf("\nRunning test 1 again (the library image is mapped in):\n");
+    run_test("test1", &mapped);
+    printf("%u tokens differ\n", compare_streams(&built, &mapped));
+    lexer_free(&built);
+    lexer_free(&mapped);
+
+    printf("\nRunning test 2 (a library with a line that is not a macro, an include without a path):\n");
+    run_test("test2", &built);
+    lexer_free(&built);
+
+    return 0;
+}
+
+unsigned int run_test(char *file_path, Lexer *lexer) {
+    Preprocessor preprocessor;
+    unsigned int library_count;
+
+    lexer_initialize_from_file(lexer, file_path);
+    lexer_analyze(lexer);
+    error_handler_report_errors(&lexer->error_handler);
+
+    preprocessor_initialize(&preprocessor, lexer, file_path);
+    preprocessor_process(&preprocessor, lexer->source_code);
+    error_handler_report_errors(&preprocessor.error_handler);
+
+    library_count = preprocessor.library_count;
+    if (library_count > 0)
+        printf("%s: %u macros, image %s\n", preprocessor.libraries[0].path, preprocessor.libraries[0].macro_count,
+               preprocessor.libraries[0].mapped ? "mapped" : "built");
+    printf("%u tokens after expansion\n", lexer->tokens.count);
+    lexer_print_token_list(lexer);
+
+    error_handler_free(&lexer->error_handler);
+    preprocessor_free(&preprocessor);
+    return library_count;
+}
+
+unsigned int compare_streams(Lexer *built, Lexer *mapped) {
+    unsigned int mismatches = 0;
+    unsigned int i;
+
+    if (built->tokens.count != mapped->tokens.count)
+        return built->tokens.count > mapped->tokens.count ? built->tokens.count : mapped->tokens.count;
+    for (i = 0; i < built->tokens.count; i++) {
+        if (built->tokens.data[i].type != mapped->tokens.data[i].type ||
+            built->tokens.data[i].length != mapped->tokens.data[i].length ||
+            memcmp(token_text(built->tokens.data[i], built->source_code),
+                   token_text(mapped->tokens.data[i], mapped->source_code), built->tokens.data[i].length) != 0) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
@@ -0,0 +1,9 @@
+.include "utils"
+MAIN: mov #5, r1
+PRINTONE
+CLEARALL
+macr LOCAL
+    inc r2
+endmacr
+LOCAL
+stop
@@ -0,0 +1,4 @@
+.include "bad_library"
+.include
+PRINTONE
+stop
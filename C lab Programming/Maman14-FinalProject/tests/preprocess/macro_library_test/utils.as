@@ -0,0 +1,10 @@
+; shared macros
+macr PRINTONE
+    prn r1
+endmacr
+
+macr CLEARALL
+    clr r1
+    clr r2
+    clr r3
+endmacr
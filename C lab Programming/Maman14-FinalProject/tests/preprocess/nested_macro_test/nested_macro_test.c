@@ -0,0 +1,42 @@
+#include "../../../headers/lexer.h"
+#include "../../../headers/preprocessor.h"
+
+/* Expands macros whose bodies call other macros, each expansion is worked out once however often it is used.
+ * Test 2 has macros that call each other in a cycle, and one that calls itself */
+
+void run_test(char *file_path) {
+    Lexer lexer;
+    Preprocessor preprocessor;
+    MacroList *node;
+
+    lexer_initialize_from_file(&lexer, file_path);
+    lexer_analyze(&lexer);
+    error_handler_report_errors(&lexer.error_handler);
+
+    preprocessor_initialize(&preprocessor, &lexer, file_path);
+    preprocessor_process(&preprocessor, lexer.source_code);
+    error_handler_report_errors(&preprocessor.error_handler);
+
+    for (node = preprocessor.macro_list; node != NULL; node = node->next) {
+        printf("%.*s: %s, %u tokens\n", (int) node->macro.identifier.length,
+               token_text(node->macro.identifier, lexer.source_code),
+               node->expansion.state == EXPANSION_DONE ? "expanded" : "not expanded", node->expansion.token_count);
+    }
+    printf("%u tokens in the expansion pool, %u after expansion\n",
+           preprocessor.expansion_tokens.count, lexer.tokens.count);
+    lexer_print_token_list(&lexer);
+
+    error_handler_free(&lexer.error_handler);
+    preprocessor_free(&preprocessor);
+    lexer_free(&lexer);
+}
+
+int main() {
+    printf("Running test 1:\n");
+    run_test("test1");
+
+    printf("\nRunning test 2 (cycles):\n");
+    run_test("test2");
+
+    return 0;
+}
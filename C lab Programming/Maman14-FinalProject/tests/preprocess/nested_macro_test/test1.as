@@ -0,0 +1,21 @@
+macr SAVE
+    mov r1, r2
+endmacr
+
+macr RESTORE
+    mov r2, r1
+endmacr
+
+macr WRAP
+    SAVE
+    inc r1
+    RESTORE
+endmacr
+
+macr TWICE
+    WRAP
+    WRAP
+endmacr
+
+MAIN: TWICE
+stop
@@ -0,0 +1,16 @@
+macr PING
+    prn r1
+    PONG
+endmacr
+
+macr PONG
+    PING
+endmacr
+
+macr SELF
+    SELF
+endmacr
+
+PONG
+SELF
+stop
@@ -10,7 +10,7 @@ void run_test(char* file_path) {
     lexer_analyze(&lexer);
     error_handler_report_errors(&lexer.error_handler);
 
-    preprocessor_initialize(&pre_processor, lexer, file_path);
+    preprocessor_initialize(&pre_processor, &lexer, file_path);
     preprocessor_process(&pre_processor, lexer.source_code);
     error_handler_report_errors(&pre_processor.error_handler);
 
@@ -6,47 +6,45 @@
 #include "../../../headers/semantic_analyzer.h"
 #include "../../../headers/string_util.h"
 
-static void print_label(LabelNode label){
-    InstructionNodeList * copyI = label.instruction_list;
+static void print_label(LabelNode label, TranslationUnit * unit, String source){
+    InstructionTable * table = &unit->instructions;
+    Token * tokens = unit->tokens.data;
     GuidanceNodeList * copyG = label.guidance_list;
-    TokenReferenceNode * list = NULL;
+    unsigned int row;
+    unsigned int index;
 
     printf("Label size: %d\n", label.size);
     printf("Label position: %d\n", label.position);
 
     if (label.label != NULL){
-        printf("%s:\n", label.label->string.data);
+        printf("%.*s:\n", (int)label.label->length, token_text(*label.label, source));
     }
 
-    while (copyI != NULL){
-        printf("    %s", copyI->node.operation->string.data);
+    for (row = label.first_instruction; row < label.first_instruction + label.instruction_count; row++){
+        printf("    %.*s", (int)tokens[table->token[row]].length, token_text(tokens[table->token[row]], source));
 
-        if (copyI->node.first_operand != NULL)
-            printf(" %s", copyI->node.first_operand->string.data);
+        if (table->source_mode[row] != 0)
+            printf(" %.*s,", (int)tokens[table->source_token[row]].length, token_text(tokens[table->source_token[row]], source));
 
-        if (copyI->node.second_operand != NULL)
-            printf(", %s", copyI->node.second_operand->string.data);
+        if (table->destination_mode[row] != 0)
+            printf(" %.*s", (int)tokens[table->destination_token[row]].length, token_text(tokens[table->destination_token[row]], source));
 
         printf("\n");
-        copyI = copyI->next;
     }
 
     while (copyG != NULL){
         if (copyG->type == DATA_NODE){
             printf("    .data ");
 
-            list = copyG->node.dataNode.data_numbers;
-
-            while (list != NULL){
-                printf("%d", atoi(list->token->string.data));
-                if (list->next != NULL) printf(", ");
-                list = list->next;
+            for (index = 0; index < copyG->node.dataNode.count; index++){
+                printf("%d", copyG->node.dataNode.numbers[index]);
+                if (index + 1 < copyG->node.dataNode.count) printf(", ");
             }
 
             printf("\n");
         } else if (copyG->type == STRING_NODE){
             if (copyG->node.stringNode.string_label != NULL)
-                printf("    .string %s\n", copyG->node.stringNode.string_label->string.data);
+                printf("    .string %.*s\n", (int)copyG->node.stringNode.string_label->length, token_text(*copyG->node.stringNode.string_label, source));
         }
 
         copyG = copyG->next;
@@ -55,7 +53,6 @@ static void print_label(LabelNode label){
 
 int main(){
     Lexer lexer_preprocess;
-    Lexer lexer_postprocess;
     Preprocessor preprocessor;
     TranslationUnit unit;
     SemanticAnalyzer analyzer;
@@ -73,22 +70,17 @@ int main(){
     error_handler_report_errors(&lexer_preprocess.error_handler);
 
     /* preprocesser pass */
-    preprocessor_initialize(&preprocessor, lexer_preprocess, file_path);
+    preprocessor_initialize(&preprocessor, &lexer_preprocess, file_path);
     preprocessor_process(&preprocessor, lexer_preprocess.source_code);
     error_handler_report_errors(&preprocessor.error_handler);
 
-    /* postprocess lexer pass */
-    lexer_initialize_from_string(&lexer_postprocess, preprocessor.error_handler.file_path, preprocessor.processed_source);
-    lexer_analyze(&lexer_postprocess);
-    error_handler_report_errors(&lexer_postprocess.error_handler);
-
     /* parser pass */
-    parser_initialize_translation_unit(&unit, lexer_postprocess);
+    parser_initialize_translation_unit(&unit, &lexer_preprocess);
     parse_translation_unit_content(&unit);
     error_handler_report_errors(&unit.error_handler);
 
     /* ast check pass */
-    semantic_analyzer_initialize(&analyzer, &unit, lexer_postprocess);
+    semantic_analyzer_initialize(&analyzer, &unit, &lexer_preprocess);
     semantic_analyzer_analyze_duplicate_identifiers(&analyzer, &unit);
     error_handler_report_errors(&analyzer.error_handler);
 
@@ -98,29 +90,28 @@ int main(){
     guidance_label_list = unit.guidance_label_list;
 
     while (external_node_list != NULL){
-        printf(".extern %s\n", external_node_list->external_node.external_label->string.data);
+        printf(".extern %.*s\n", (int)external_node_list->external_node.external_label->length, token_text(*external_node_list->external_node.external_label, lexer_preprocess.source_code));
         external_node_list = external_node_list->next;
     }
 
     while (entryNodeList != NULL){
-        printf(".entry %s\n", entryNodeList->entry_node.entry_label->string.data);
+        printf(".entry %.*s\n", (int)entryNodeList->entry_node.entry_label->length, token_text(*entryNodeList->entry_node.entry_label, lexer_preprocess.source_code));
         entryNodeList = entryNodeList->next;
     }
 
     while (instruction_label_list != NULL){
-        print_label(instruction_label_list->label);
+        print_label(instruction_label_list->label, &unit, lexer_preprocess.source_code);
         instruction_label_list = instruction_label_list->next;
     }
 
     while (guidance_label_list != NULL){
-        print_label(guidance_label_list->label);
+        print_label(guidance_label_list->label, &unit, lexer_preprocess.source_code);
         guidance_label_list = guidance_label_list->next;
     }
 
     semantic_analyzer_free(&analyzer);
     parser_free_translation_unit(&unit);
     preprocessor_free(&preprocessor);
-    lexer_free(&lexer_postprocess);
     lexer_free(&lexer_preprocess);
 
     return 0;
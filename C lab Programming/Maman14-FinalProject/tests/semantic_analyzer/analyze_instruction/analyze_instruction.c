@@ -8,7 +8,6 @@
 
 int main(){
     Lexer lexer_preprocess;
-    Lexer lexer_postprocess;
     Preprocessor preprocessor;
     TranslationUnit unit;
     SemanticAnalyzer analyzer;
@@ -22,32 +21,24 @@ int main(){
     error_handler_report_errors(&lexer_preprocess.error_handler);
 
     /* preprocesser */
-    preprocessor_initialize(&preprocessor, lexer_preprocess, file_path);
+    preprocessor_initialize(&preprocessor, &lexer_preprocess, file_path);
     preprocessor_process(&preprocessor, lexer_preprocess.source_code);
     error_handler_report_errors(&preprocessor.error_handler);
 
-    /* postprocess lexer  */
-    lexer_initialize_from_string(&lexer_postprocess, preprocessor.error_handler.file_path, preprocessor.processed_source);
-    lexer_analyze(&lexer_postprocess);
-    error_handler_report_errors(&lexer_postprocess.error_handler);
-
     /* parser*/
-    parser_initialize_translation_unit(&unit, lexer_postprocess);
+    parser_initialize_translation_unit(&unit, &lexer_preprocess);
     parse_translation_unit_content(&unit);
     error_handler_report_errors(&unit.error_handler);
 
     /* Analyzer */
-    semantic_analyzer_initialize(&analyzer, &unit, lexer_postprocess);
+    semantic_analyzer_initialize(&analyzer, &unit, &lexer_preprocess);
     semantic_analyzer_analyze_duplicate_identifiers(&analyzer, &unit);
 
     instruction_label_list = unit.instruction_label_list;
 
+    /* An instruction label has no guidance, so analyzing it validates just its instruction rows */
     while (instruction_label_list != NULL){
-        while (instruction_label_list->label.instruction_list != NULL){
-            semantic_analyzer_analyze_instruction(&analyzer, instruction_label_list->label.instruction_list->node);
-            instruction_label_list->label.instruction_list = instruction_label_list->label.instruction_list->next;
-        }
-
+        semantic_analyzer_analyze_label(&analyzer, instruction_label_list->label);
         instruction_label_list = instruction_label_list->next;
     }
 
@@ -56,7 +47,6 @@ int main(){
     semantic_analyzer_free(&analyzer);
     parser_free_translation_unit(&unit);
     preprocessor_free(&preprocessor);
-    lexer_free(&lexer_postprocess);
     lexer_free(&lexer_preprocess);
 
     return 0;
@@ -70,6 +70,17 @@ void string_append_cstr(String *str, const char *cstr) {
     str->length += len;
 }
 
+void string_append_chars(String *str, const char *chars, unsigned int count) {
+    while (str->length + count + 1 > str->capacity) {
+        str->capacity *= 2;
+        str->data = safe_realloc(str->data, str->capacity);
+    }
+
+    memcpy(str->data + str->length, chars, count);
+    str->length += count;
+    str->data[str->length] = '\0';
+}
+
 void string_append(String *dest, String src) {
     string_append_cstr(dest, src.data);
 }
@@ -146,3 +157,13 @@ static unsigned next_power_of_two(unsigned x) {
     return x + 1;
 }
 
+unsigned long compute_string_hash(const char *data, unsigned int length) {
+    unsigned long h = 5381;
+    const unsigned char *us = (const unsigned char *) data;
+
+    while (length-- > 0) {
+        h = ((h << 5) + h) + *us++;
+    }
+
+    return h;
+}